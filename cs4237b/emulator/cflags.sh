@@ -0,0 +1,15 @@
+# Copyright (C) 2026  linic@hotmail.ca Subject to GPL-3.0 license.
+# https://github.com/linic/tcl-core-560z
+#
+# Sourced by run.sh and iodiff.sh so the harness and the tree comparison build
+# the driver the same way. A driver change which adds a warning fails both.
+# EMU_CFLAGS replaces the config of the 560z .config.
+EMU_WARN="-Wall -Werror"
+EMU_CFLAGS=${EMU_CFLAGS:--DCONFIG_PM -DCONFIG_SND_PROC_FS=1 -DCONFIG_SND_WSS_CS4237B_ONLY}
+
+# emu_cflags <driver tree>
+emu_cflags()
+{
+	echo "-std=gnu11 -O1 -g $EMU_WARN $EMU_CFLAGS -Iinclude -I$1/include" \
+	     "-I$1/sound/isa/wss -include include/kstub.h"
+}
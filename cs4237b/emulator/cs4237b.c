@@ -0,0 +1,594 @@
+/*
+ * Copyright (C) 2026  linic@hotmail.ca Subject to GPL-3.0 license.
+ * https://github.com/linic/tcl-core-560z
+ *
+ * The CS4237B as the driver sees it through WSSbase (R0-R3) and the 8237.
+ * Everything here comes from CS4237B.PDF (DS213PP4). Where the datasheet
+ * doesn't say, the comment says what was picked.
+ */
+#include <string.h>
+#include "cs4237b.h"
+
+uint64_t emu_now;
+struct cs4237b codec;
+
+#define R0_INIT		0x80
+#define R0_MCE		0x40
+#define R0_TRD		0x20
+#define I9_PEN		0x01
+#define I9_CEN		0x02
+#define I9_SDC		0x04
+#define I9_PPIO		0x40
+#define I9_CPIO		0x80
+#define I10_IEN		0x02
+#define I11_DRS		0x10
+#define I11_ACI		0x20
+#define I16_PMCE	0x10
+#define I16_CMCE	0x20
+#define I16_TE		0x40
+#define I23_XRAE	0x08
+#define I24_PI		0x10
+#define I24_CI		0x20
+#define I24_TI		0x40
+#define I24_IRQS	(I24_PI | I24_CI | I24_TI)
+#define X11_IFSE	0x20
+
+/* I0-I31 right after RESDRV. Same values as snd_wss_reset_image in wss_lib.c. */
+static const uint8_t reset_i[32] = {
+	0x00, 0x00, 0xe8, 0xe8, 0xc8, 0xc8, 0x80, 0x80,
+	0x00, 0x08, 0x00, 0x00, 0x8a, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x03, 0xa0, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+/* X0-X17 right after RESDRV; X12 and X13 are undefined, 0 is taken. */
+static const uint8_t reset_x[18] = {
+	0xe8, 0xe8, 0xcf, 0xcf, 0x84, 0x00, 0x80, 0x80, 0x00,
+	0x00, 0x3f, 0xc0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+#define X25_VERSION	0xe8	/* revision E, CS4237B; what the 560z reads */
+
+/* Sample periods of a calibration for CAL1,0 in I9. */
+static const unsigned int calib_periods[4] = { 0, 321, 120, 450 };
+
+static int mode(const struct cs4237b *c)
+{
+	switch (c->i[12] & 0x60) {
+	case 0x60:	return 3;
+	case 0x40:	return 2;
+	default:	return 1;
+	}
+}
+
+static bool init_set(const struct cs4237b *c)
+{
+	return emu_now < c->init_until;
+}
+
+static bool stream_on(const struct cs4237b *c, int capture)
+{
+	if (capture)
+		return (c->i[9] & (I9_CEN | I9_CPIO)) == I9_CEN;
+	return (c->i[9] & (I9_PEN | I9_PPIO)) == I9_PEN;
+}
+
+static void update_line(struct cs4237b *c)
+{
+	bool line = (c->i[24] & I24_IRQS) && (c->i[10] & I10_IEN);
+
+	if (line && !c->line)
+		c->edge = true;
+	c->line = line;
+}
+
+void cs4237b_dma_reset(struct cs4237b *c)
+{
+	int ch;
+
+	memset(c->dma, 0, sizeof(c->dma));
+	for (ch = 0; ch < 4; ch++)
+		c->dma[ch].masked = true;
+	c->dma_ff = false;
+}
+
+void cs4237b_reset(struct cs4237b *c, bool cold, uint64_t init_ns)
+{
+	int dma_play = c->dma_play, dma_cap = c->dma_cap;
+	struct cs4237b_faults f = c->f;
+	unsigned int calibrations = c->calibrations;
+
+	memset(c, 0, sizeof(*c));
+	c->dma_play = dma_play ? dma_play : CS4237B_DMA1;
+	c->dma_cap = dma_cap ? dma_cap : CS4237B_DMA2;
+	c->f = f;
+	c->calibrations = calibrations;
+	memcpy(c->i, reset_i, sizeof(reset_i));
+	memcpy(c->x, reset_x, sizeof(reset_x));
+	/* "Immediately after RESET (and once the WSS Codec has left the INIT
+	 * state), the state of this register is: 010x0000". */
+	c->r0 = R0_MCE;
+	if (!cold) {
+		c->r0 = 0;
+		c->i[12] = 0xe0;
+		c->i[9] &= ~0x18;
+		c->x[11] = 0xe0;
+		c->x[12] = 0x01;
+		c->x[13] = 0x01;
+	}
+	c->init_until = emu_now + init_ns;
+	cs4237b_dma_reset(c);
+}
+
+unsigned int cs4237b_rate(const struct cs4237b *c, int capture)
+{
+	static const unsigned int xtal1[8] = { 8000, 16000, 27420, 32000, 0, 0, 48000, 9600 };
+	static const unsigned int xtal2[8] = { 5512, 11025, 18900, 22050, 37800, 44100, 33075, 6615 };
+	static const unsigned int divisor[8] = { 0, 353, 529, 617, 1058, 1764, 2117, 2558 };
+	uint8_t sr;
+
+	if (mode(c) == 3 && (c->x[11] & X11_IFSE)) {
+		sr = c->x[capture ? 12 : 13];
+		if (sr >= 1 && sr <= 7)
+			return 16934400 / divisor[sr];
+		if (sr >= 21 && sr <= 192)
+			return 16934400 / 16 / sr;
+		return 0;	/* reserved values, nothing runs */
+	}
+	return (c->i[8] & 1 ? xtal2 : xtal1)[(c->i[8] >> 1) & 7];
+}
+
+static uint64_t frame_ns(const struct cs4237b *c, int capture)
+{
+	unsigned int rate = cs4237b_rate(c, capture);
+
+	return rate ? 1000000000ULL / rate : 0;
+}
+
+/* Calibration starts when MCE goes from 1 to 0 with CAL1,0 set. Only ACI
+ * tells it's running: the datasheet sets INIT for initialization and power
+ * down only, so R1 keeps answering. */
+static void mce_down(struct cs4237b *c)
+{
+	unsigned int periods = calib_periods[(c->i[9] >> 3) & 3];
+	unsigned int rate = cs4237b_rate(c, 0);
+
+	if (!periods)
+		return;
+	if (!rate)
+		rate = 48000;
+	c->aci_until = emu_now + (uint64_t)periods * 1000000000ULL / rate;
+	c->calibrations++;
+}
+
+static uint16_t count_base(const struct cs4237b *c, int capture)
+{
+	if (capture && mode(c) > 1 && !(c->i[9] & I9_SDC))
+		return c->i[30] << 8 | c->i[31];
+	return c->i[14] << 8 | c->i[15];
+}
+
+/* Write the bits of Ix which aren't locked and count the locked ones the
+ * driver tried to change. */
+static void write_locked(struct cs4237b *c, int reg, uint8_t val, uint8_t locked)
+{
+	if ((c->i[reg] ^ val) & locked)
+		c->f.locked_writes++;
+	c->i[reg] = (c->i[reg] & locked) | (val & ~locked);
+}
+
+static void write_x(struct cs4237b *c, uint8_t val)
+{
+	int reg = c->xreg;
+
+	if (reg >= 18)
+		return;		/* X18-X24 reserved, X25 read-only */
+	if ((reg == 12 || reg == 13) && !(c->x[11] & X11_IFSE)) {
+		if (c->x[reg] != val)
+			c->f.x_locked_writes++;
+		return;
+	}
+	c->x[reg] = val;
+}
+
+static void write_i(struct cs4237b *c, uint8_t val)
+{
+	int reg = c->r0 & 0x1f;
+	bool mce = c->r0 & R0_MCE;
+	uint8_t old;
+
+	if (mode(c) == 1)
+		reg &= 0x0f;
+	old = c->i[reg];
+	switch (reg) {
+	case 8:
+		/* D7-D4 with MCE or PMCE, the rate bits with MCE only. */
+		write_locked(c, reg, val, mce ? 0 : c->i[16] & I16_PMCE ? 0x0f : 0xff);
+		break;
+	case 9:
+		/* PEN and CEN can change on the fly. */
+		write_locked(c, reg, val, mce ? 0 : 0xfc);
+		if (!(old & I9_PEN) && stream_on(c, 0)) {
+			c->s[0].next = emu_now + frame_ns(c, 0);
+			c->s[0].owed = 0;
+		}
+		if (!(old & I9_CEN) && stream_on(c, 1)) {
+			c->s[1].next = emu_now + frame_ns(c, 1);
+			c->s[1].owed = 0;
+		}
+		break;
+	case 11:
+	case 25:
+		break;		/* read-only */
+	case 12:
+		c->i[12] = (c->i[12] & ~0x60) | (val & 0x60);
+		if (mode(c) != 3)
+			c->xrae = false;
+		break;
+	case 14:
+		c->i[14] = val;
+		/* Writing the upper base loads the current count. */
+		c->s[0].count = count_base(c, 0);
+		if (mode(c) == 1 || (c->i[9] & I9_SDC))
+			c->s[1].count = count_base(c, 1);
+		break;
+	case 16:
+		write_locked(c, reg, val, mce ? 0 : 0x02);	/* SPE */
+		if (!(old & I16_TE) && (val & I16_TE)) {
+			c->tcount = c->i[21] << 8 | c->i[20];
+			c->tnext = emu_now + 10000;
+		}
+		break;
+	case 23:
+		if (mode(c) != 3) {
+			c->i[23] = val;
+			break;
+		}
+		if (c->xrae) {
+			write_x(c, val);
+			break;
+		}
+		c->i[23] = val;
+		if (val & I23_XRAE) {
+			c->xrae = true;
+			c->xreg = ((val >> 4) & 0x0f) | ((val & 0x04) << 2);
+		}
+		break;
+	case 24:
+		/* PI, CI and TI are cleared by writing 0 to them. */
+		c->i[24] &= val | ~I24_IRQS;
+		break;
+	case 28:
+		write_locked(c, reg, val, mce || (c->i[16] & I16_CMCE) ? 0 : 0xf0);
+		break;
+	case 30:
+		c->i[30] = val;
+		c->s[1].count = count_base(c, 1);
+		break;
+	default:
+		c->i[reg] = val;
+		break;
+	}
+	update_line(c);
+}
+
+static uint8_t read_i(struct cs4237b *c)
+{
+	int reg = c->r0 & 0x1f;
+	uint8_t val;
+
+	if (mode(c) == 1)
+		reg &= 0x0f;
+	switch (reg) {
+	case 11:
+		val = emu_now < c->aci_until ? I11_ACI : 0;
+		if (stream_on(c, 0) || stream_on(c, 1))
+			val |= I11_DRS;
+		if (stream_on(c, 1))
+			val |= c->overrange & 0x0f;
+		return val;
+	case 12:
+		return 0x80 | (c->i[12] & 0x60) | 0x0a;
+	case 23:
+		if (mode(c) == 3 && c->xrae) {
+			if (c->xreg == 25)
+				return X25_VERSION;
+			return c->xreg < 18 ? c->x[c->xreg] : 0;
+		}
+		return c->i[23];
+	case 25:
+		return 0x03;
+	default:
+		return c->i[reg];
+	}
+}
+
+uint8_t cs4237b_reg_mask(int reg)
+{
+	switch (reg) {
+	case 11: case 23: case 24: case 25:
+		return 0;
+	case 12:
+		return 0x60;
+	default:
+		return 0xff;
+	}
+}
+
+uint8_t cs4237b_ereg_mask(int reg)
+{
+	return reg < 18 ? 0xff : 0;
+}
+
+/*
+ *  8237
+ */
+
+static uint8_t dma_in(struct cs4237b *c, unsigned long port)
+{
+	struct cs4237b_dma *d;
+	uint16_t v;
+
+	if (port > 0x07)
+		return 0;	/* status, not used by the driver */
+	d = &c->dma[port >> 1];
+	v = port & 1 ? d->count : d->addr;
+	c->dma_ff = !c->dma_ff;
+	return c->dma_ff ? v & 0xff : v >> 8;
+}
+
+static void dma_out(struct cs4237b *c, uint8_t val, unsigned long port)
+{
+	static const uint8_t page_port[4] = { 0x87, 0x83, 0x81, 0x82 };
+	struct cs4237b_dma *d;
+	int ch;
+
+	for (ch = 0; ch < 4; ch++)
+		if (port == page_port[ch]) {
+			c->dma[ch].page = val;
+			return;
+		}
+	if (port <= 0x07) {
+		d = &c->dma[port >> 1];
+		if (port & 1)
+			d->base_count = c->dma_ff ? (d->base_count & 0xff) | val << 8 :
+						    (d->base_count & 0xff00) | val;
+		else
+			d->base_addr = c->dma_ff ? (d->base_addr & 0xff) | val << 8 :
+						   (d->base_addr & 0xff00) | val;
+		d->count = d->base_count;
+		d->addr = d->base_addr;
+		c->dma_ff = !c->dma_ff;
+		return;
+	}
+	switch (port) {
+	case 0x0a:	/* single mask */
+		c->dma[val & 3].masked = val & 4;
+		break;
+	case 0x0b:	/* mode */
+		c->dma[val & 3].mode = val & 0xfc;
+		c->dma[val & 3].mode_checked = false;
+		break;
+	case 0x0c:	/* clear flip-flop */
+		c->dma_ff = false;
+		break;
+	case 0x0d:	/* master clear */
+		cs4237b_dma_reset(c);
+		break;
+	case 0x0e:
+		for (ch = 0; ch < 4; ch++)
+			c->dma[ch].masked = false;
+		break;
+	case 0x0f:
+		for (ch = 0; ch < 4; ch++)
+			c->dma[ch].masked = val & (1 << ch);
+		break;
+	}
+}
+
+static bool dma_port(unsigned long port)
+{
+	return port <= 0x0f || (port >= 0x80 && port <= 0x8f);
+}
+
+/* One byte over the 8237 channel. False when the channel doesn't answer DRQ. */
+static bool dma_byte(struct cs4237b *c, int ch, int capture)
+{
+	struct cs4237b_dma *d = &c->dma[ch];
+
+	if (d->masked)
+		return false;
+	if (!d->mode_checked) {
+		/* DMA_MODE_READ (I/O to memory) for capture, DMA_MODE_WRITE for playback */
+		if (((d->mode >> 2) & 3) != (capture ? 1 : 2))
+			c->f.bad_dma_mode++;
+		d->mode_checked = true;
+	}
+	d->addr += d->mode & 0x20 ? -1 : 1;
+	if (d->count-- == 0) {
+		/* terminal count */
+		if (d->mode & 0x10) {
+			d->addr = d->base_addr;
+			d->count = d->base_count;
+		} else {
+			d->masked = true;
+		}
+	}
+	return true;
+}
+
+static void count_tick(struct cs4237b *c, int capture)
+{
+	struct cs4237b_stream *s = &c->s[capture];
+
+	/* "The next sample after zero generates an interrupt and reloads the
+	 * Current Count registers with the values in the Base registers." */
+	if (s->count == 0) {
+		c->i[24] |= capture ? I24_CI : I24_PI;
+		s->count = count_base(c, capture);
+	} else {
+		s->count--;
+	}
+}
+
+/* One sample period of playback or capture. The 16 sample FIFO between the
+ * 8237 and the DAC/ADC covers the few us the 8237 is masked while the driver
+ * reads its count; only when the FIFO is used up is it an underrun. */
+static void stream_frame(struct cs4237b *c, int capture)
+{
+	struct cs4237b_stream *s = &c->s[capture];
+	uint8_t fmt = capture && mode(c) > 1 ? c->i[28] : c->i[8];
+	int ch = capture ? c->dma_cap : c->dma_play;
+	bool adpcm = (fmt >> 5) == 5;
+	unsigned int halfbytes;
+
+	switch (fmt >> 5) {
+	case 2:
+	case 6:
+		halfbytes = 4;	/* 16 bit */
+		break;
+	case 5:
+		halfbytes = 1;	/* IMA ADPCM */
+		break;
+	default:
+		halfbytes = 2;
+		break;
+	}
+	if (fmt & 0x10)
+		halfbytes *= 2;
+	s->halfbytes += halfbytes;
+	while (s->halfbytes >= 2) {
+		s->halfbytes -= 2;
+		s->owed++;
+		if (adpcm && ++s->adpcm_bytes == 4) {
+			s->adpcm_bytes = 0;
+			count_tick(c, capture);
+		}
+	}
+	/* TRD holds DRQ while INT is set. */
+	while (s->owed && !((c->r0 & R0_TRD) && (c->i[24] & I24_IRQS)) &&
+	       dma_byte(c, ch, capture))
+		s->owed--;
+	if (s->owed > 16 * halfbytes / 2) {
+		c->f.underruns++;
+		s->owed = 0;
+	}
+	if (!adpcm)
+		count_tick(c, capture);
+}
+
+bool cs4237b_run(struct cs4237b *c, uint64_t until)
+{
+	for (;;) {
+		uint64_t next = UINT64_MAX;
+		int what = -1, capture;
+
+		if (c->edge)
+			return true;
+		for (capture = 0; capture < 2; capture++)
+			if (stream_on(c, capture) && frame_ns(c, capture) &&
+			    c->s[capture].next < next) {
+				next = c->s[capture].next;
+				what = capture;
+			}
+		if ((c->i[16] & I16_TE) && c->tnext < next) {
+			next = c->tnext;
+			what = 2;
+		}
+		if (what < 0 || next > until)
+			break;
+		if (next > emu_now)
+			emu_now = next;
+		if (what == 2) {
+			c->tnext += 10000;
+			if (c->tcount-- == 0) {
+				c->i[24] |= I24_TI;
+				c->tcount = c->i[21] << 8 | c->i[20];
+			}
+		} else {
+			c->s[what].next += frame_ns(c, what);
+			stream_frame(c, what);
+		}
+		update_line(c);
+	}
+	if (until > emu_now)
+		emu_now = until;
+	return false;
+}
+
+uint8_t cs4237b_port_in(struct cs4237b *c, unsigned long port, bool *handled)
+{
+	*handled = true;
+	if (dma_port(port))
+		return dma_in(c, port);
+	switch (port - CS4237B_PORT) {
+	case 0:
+		return init_set(c) ? R0_INIT : c->r0;
+	case 1:
+		/* "During initialization and software power down of the WSS Codec,
+		 * this register can NOT be written and is always read 10000000" */
+		return init_set(c) ? 0x80 : read_i(c);
+	case 2:
+		return (c->i[24] & I24_IRQS) ? 0x01 : 0x00;
+	case 3:
+		return 0;	/* PIO data, the driver only uses DMA */
+	}
+	*handled = false;
+	return 0xff;
+}
+
+void cs4237b_port_out(struct cs4237b *c, uint8_t val, unsigned long port, bool *handled)
+{
+	*handled = true;
+	if (dma_port(port)) {
+		dma_out(c, val, port);
+		return;
+	}
+	switch (port - CS4237B_PORT) {
+	case 0:
+		if (init_set(c)) {
+			c->f.lost_writes++;
+			return;
+		}
+		/* Writing R0 turns I23 back into the X address register. */
+		c->xrae = false;
+		if ((c->r0 & R0_MCE) && !(val & R0_MCE)) {
+			c->r0 = val & 0x7f;
+			mce_down(c);
+		} else {
+			c->r0 = val & 0x7f;
+		}
+		return;
+	case 1:
+		if (init_set(c)) {
+			c->f.lost_writes++;
+			return;
+		}
+		write_i(c, val);
+		return;
+	case 2:
+		/* Any write to R2 clears PI, CI and TI. */
+		c->i[24] &= ~I24_IRQS;
+		update_line(c);
+		return;
+	case 3:
+		return;
+	}
+	*handled = false;
+}
+
+unsigned int cs4237b_fault_count(const struct cs4237b *c)
+{
+	return c->f.lost_writes + c->f.locked_writes + c->f.x_locked_writes +
+	       c->f.bad_ports + c->f.bad_dma_mode + c->f.underruns;
+}
+
+void cs4237b_print_faults(const struct cs4237b *c, FILE *f)
+{
+	fprintf(f, "writes lost while INIT was set\t%u\n", c->f.lost_writes);
+	fprintf(f, "locked bits written without MCE\t%u\n", c->f.locked_writes);
+	fprintf(f, "X12/X13 written with IFSE clear\t%u\n", c->f.x_locked_writes);
+	fprintf(f, "accesses to unknown ports\t%u\n", c->f.bad_ports);
+	fprintf(f, "8237 direction mismatches\t%u\n", c->f.bad_dma_mode);
+	fprintf(f, "playback/capture underruns\t%u\n", c->f.underruns);
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2026  linic@hotmail.ca Subject to GPL-3.0 license.
+ * https://github.com/linic/tcl-core-560z
+ *
+ * Register level model of the CS4237B WSS codec of the 560z and of the two
+ * 8237 channels it uses. Only what the driver can see through the ports is
+ * modelled: R0-R3, I0-I31, X0-X25 behind I23, INIT, MCE, ACI, the I24
+ * interrupt bits, the playback/capture counters and the 8237 counters.
+ * No audio goes anywhere.
+ */
+#ifndef CS4237B_H
+#define CS4237B_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/* Resources of the 560z, see cs4237b/tools and the .config. */
+#define CS4237B_PORT	0x530
+#define CS4237B_IRQ	5
+#define CS4237B_DMA1	1	/* playback */
+#define CS4237B_DMA2	3	/* capture */
+
+/* About 1 us per ISA I/O cycle, like the budget comment in wss_lib.c says. */
+#define CS4237B_IO_NS	1000
+
+/* Simulated time in ns. Everything which waits moves it forward. */
+extern uint64_t emu_now;
+
+/* One 8237 channel. */
+struct cs4237b_dma {
+	uint16_t base_addr, base_count;
+	uint16_t addr, count;
+	uint8_t page, mode;
+	bool masked;
+	bool mode_checked;	/* direction compared with the stream since the last mode write */
+};
+
+/* Playback (0) or capture (1) side of the codec. */
+struct cs4237b_stream {
+	uint16_t count;		/* current count, not readable */
+	uint64_t next;		/* time of the next frame */
+	uint8_t halfbytes;	/* left over from IMA ADPCM frames */
+	uint8_t adpcm_bytes;	/* ADPCM counts 4 bytes at a time */
+	uint16_t owed;		/* bytes the 16 sample FIFO is waiting for from the 8237 */
+};
+
+/* What the model saw the driver do wrong. Every one of them fails the run. */
+struct cs4237b_faults {
+	unsigned int lost_writes;	/* R0/R1 written while INIT is set */
+	unsigned int locked_writes;	/* I8/I9/I16/I28 bits changed without MCE/PMCE/CMCE */
+	unsigned int x_locked_writes;	/* X12/X13 changed with IFSE clear */
+	unsigned int bad_ports;		/* access to a port nothing answers */
+	unsigned int bad_dma_mode;	/* 8237 direction doesn't match the stream */
+	unsigned int underruns;		/* FIFO ran dry (or over) because the 8237 didn't answer */
+};
+
+struct cs4237b {
+	uint8_t r0;		/* TRD, MCE and IA4-IA0; INIT comes from init_until */
+	uint8_t i[32];		/* what the codec holds; read-only bits are made up on reads */
+	uint8_t x[32];
+	bool xrae;		/* I23 is the X data register until R0 is written */
+	uint8_t xreg;
+	uint64_t init_until;	/* INIT reads 1 before this */
+	uint64_t aci_until;	/* ACI reads 1 before this */
+	uint8_t overrange;	/* ORL/ORR bits of I11 while capturing */
+	struct cs4237b_stream s[2];
+	uint64_t tnext;		/* next timer tick */
+	uint16_t tcount;
+	bool line;		/* INT && IEN */
+	bool edge;		/* rising edge of line not given to the PIC yet */
+	int dma_play, dma_cap;
+	struct cs4237b_dma dma[4];
+	bool dma_ff;
+	unsigned int calibrations;
+	struct cs4237b_faults f;
+};
+
+extern struct cs4237b codec;
+
+/* cold: datasheet reset values with MCE set in R0, like after RESDRV or a
+ * power loss. Otherwise the codec is how a previous load of the driver left
+ * it: MODE 3, MCE clear and the X rates at 48 kHz. INIT stays set init_ns. */
+void cs4237b_reset(struct cs4237b *c, bool cold, uint64_t init_ns);
+/* The 8237 loses its programming over a suspend. */
+void cs4237b_dma_reset(struct cs4237b *c);
+uint8_t cs4237b_port_in(struct cs4237b *c, unsigned long port, bool *handled);
+void cs4237b_port_out(struct cs4237b *c, uint8_t val, unsigned long port, bool *handled);
+/* Play/capture/timer up to until. Returns early, with emu_now at the time it
+ * happened, when the IRQ line goes up. */
+bool cs4237b_run(struct cs4237b *c, uint64_t until);
+/* Current sample rate in Hz of the DAC (capture = 0) or the ADC. */
+unsigned int cs4237b_rate(const struct cs4237b *c, int capture);
+/* Writable bits of Ix and Xx, the ones the driver image can be compared with. */
+uint8_t cs4237b_reg_mask(int reg);
+uint8_t cs4237b_ereg_mask(int reg);
+void cs4237b_print_faults(const struct cs4237b *c, FILE *f);
+unsigned int cs4237b_fault_count(const struct cs4237b *c);
+
+#endif
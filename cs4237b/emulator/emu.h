@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2026  linic@hotmail.ca Subject to GPL-3.0 license.
+ * https://github.com/linic/tcl-core-560z
+ *
+ * What kernel.c gives harness.c besides the kernel functions themselves.
+ */
+#ifndef EMU_H
+#define EMU_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+struct snd_card;
+struct snd_pcm;
+struct snd_kcontrol;
+struct snd_info_entry;
+
+/* Everything one harness operation cost. The harness takes a copy before the
+ * operation and subtracts. */
+struct emu_counters {
+	uint64_t codec_in, codec_out;	/* WSSbase accesses */
+	uint64_t dma_io;		/* 8237 accesses */
+	uint64_t udelay_ns;		/* udelay/ndelay/mdelay, the CPU is busy */
+	uint64_t sleep_ns;		/* msleep/usleep_range, the CPU is free */
+	uint64_t irqoff_max_ns;		/* longest stretch with interrupts off */
+	unsigned int irqs;		/* handler calls */
+	unsigned int periods[2];	/* snd_pcm_period_elapsed, playback and capture */
+	unsigned int faults;		/* kernel side faults, see emu_fault */
+};
+
+extern struct emu_counters emu_cnt;
+extern int emu_verbose;
+extern FILE *emu_trace;		/* every port access when not NULL */
+
+extern struct snd_card emu_card;
+extern struct snd_pcm *emu_pcm;
+
+/* Something the real kernel would complain about: sleeping with interrupts
+ * off, taking a held lock, waiting for something which never comes... */
+void emu_fault(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+/* Let ns of idle time pass: IRQs come in, queued work runs. */
+void emu_run(uint64_t ns);
+/* Mark the trace with the name of the operation which follows. */
+void emu_trace_mark(const char *name);
+/* Set a module parameter registered with module_param. */
+int emu_param_set(const char *name, const char *val);
+struct snd_kcontrol *emu_ctl_find(const char *name);
+struct snd_info_entry *emu_proc_find(const char *name);
+/* Read a proc entry into buf, or write text to it. */
+int emu_proc_read(const char *name, char *buf, size_t size);
+int emu_proc_write(const char *name, const char *text);
+/* The devm actions, last registered first, like when the device goes away. */
+void emu_devm_release(void);
+/* True when no lock is held and interrupts are on, as between two syscalls. */
+bool emu_idle_context(void);
+
+#endif
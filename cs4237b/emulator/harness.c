@@ -0,0 +1,571 @@
+/*
+ * Copyright (C) 2026  linic@hotmail.ca Subject to GPL-3.0 license.
+ * https://github.com/linic/tcl-core-560z
+ *
+ * Drives wss_lib.c and cs4236_lib.c against the CS4237B model the way ALSA
+ * and cs4236.c would on the 560z: probe, open, hw_params, prepare, trigger,
+ * a second of playback with its period interrupts, capture, mixer, the
+ * wss_regs proc file and suspend/resume with and without losing the codec
+ * registers. Every operation prints what it cost in port I/O and in
+ * simulated time, so a change which adds I/O or waits shows up as a number.
+ *
+ * The run fails (exit 1) when the model saw a fault, when the registers the
+ * driver thinks it wrote aren't what the codec has, when interrupts stayed
+ * off longer than WSS_IRQOFF_BUDGET_US or when the period interrupts don't
+ * come at the rate of the stream.
+ */
+#include <getopt.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <sound/core.h>
+#include <sound/wss.h>
+#include "cs4237b.h"
+#include "emu.h"
+
+#define IRQOFF_BUDGET_NS	(200 * NSEC_PER_USEC)	/* WSS_IRQOFF_BUDGET_US */
+#define SUSPEND_INIT_NS		(3 * NSEC_PER_MSEC)	/* t_INIT after power comes back */
+
+static struct snd_wss *chip;
+static struct snd_pcm_substream subs[2];
+static struct snd_pcm_runtime runtimes[2];
+static struct snd_pcm_mmap_status statuses[2];
+static struct snd_pcm_hw_params hw_params[2];
+static int failed;
+
+/* What one operation costs, printed as a row of the table. */
+static struct {
+	const char *name;
+	struct emu_counters cnt;
+	unsigned int faults;
+	uint64_t start;
+} op;
+
+static unsigned int all_faults(void)
+{
+	return emu_cnt.faults + cs4237b_fault_count(&codec);
+}
+
+static void fail(const char *fmt, ...)
+{
+	va_list ap;
+
+	failed = 1;
+	printf("FAIL %s: ", op.name);
+	va_start(ap, fmt);
+	vprintf(fmt, ap);
+	va_end(ap);
+	putchar('\n');
+}
+
+static void op_begin(const char *name)
+{
+	op.name = name;
+	emu_cnt.irqoff_max_ns = 0;
+	op.cnt = emu_cnt;
+	op.faults = all_faults();
+	op.start = emu_now;
+	emu_trace_mark(name);
+}
+
+static struct emu_counters op_end(void)
+{
+	struct emu_counters d = emu_cnt;
+
+	d.codec_in -= op.cnt.codec_in;
+	d.codec_out -= op.cnt.codec_out;
+	d.dma_io -= op.cnt.dma_io;
+	d.udelay_ns -= op.cnt.udelay_ns;
+	d.sleep_ns -= op.cnt.sleep_ns;
+	d.irqs -= op.cnt.irqs;
+	d.periods[0] -= op.cnt.periods[0];
+	d.periods[1] -= op.cnt.periods[1];
+	printf("%-24s %6llu %6llu %5llu %8llu %8llu %7llu %5u %5u %8.3f %3u\n",
+	       op.name, (unsigned long long)d.codec_in, (unsigned long long)d.codec_out,
+	       (unsigned long long)d.dma_io, (unsigned long long)d.udelay_ns / 1000,
+	       (unsigned long long)d.sleep_ns / 1000,
+	       (unsigned long long)d.irqoff_max_ns / 1000, d.irqs,
+	       d.periods[0] + d.periods[1], (emu_now - op.start) / 1e6,
+	       all_faults() - op.faults);
+	if (all_faults() != op.faults)
+		fail("%u faults", all_faults() - op.faults);
+	if (d.irqoff_max_ns > IRQOFF_BUDGET_NS)
+		fail("interrupts off for %llu us", (unsigned long long)d.irqoff_max_ns / 1000);
+	if (!emu_idle_context())
+		fail("returned with a lock held or interrupts off");
+	return d;
+}
+
+/* Registers the driver doesn't have waiting in the image must be in the codec. */
+static void check_drift(void)
+{
+	unsigned int pending = chip->pending_regs | chip->mixer_regs;
+	unsigned int epending = chip->pending_eregs | chip->mixer_eregs;
+	uint8_t mask;
+	int reg;
+
+	for (reg = 0; reg < 32; reg++) {
+		mask = cs4237b_reg_mask(reg);
+		if (!(pending & BIT(reg)) && ((codec.i[reg] ^ chip->image[reg]) & mask))
+			fail("I%d is 0x%02x in the codec, 0x%02x in the image", reg,
+			     codec.i[reg], chip->image[reg]);
+	}
+	for (reg = 0; reg < 18; reg++) {
+		mask = cs4237b_ereg_mask(reg);
+		if (!(epending & BIT(reg)) && ((codec.x[reg] ^ chip->eimage[reg]) & mask))
+			fail("X%d is 0x%02x in the codec, 0x%02x in the eimage", reg,
+			     codec.x[reg], chip->eimage[reg]);
+	}
+}
+
+/* The period interrupts of duration ns must match the stream rate, give or
+ * take the one which is about to come. */
+static void check_periods(int stream, unsigned int got, uint64_t ns)
+{
+	const struct snd_pcm_hw_params *p = &hw_params[stream];
+	double want = (double)p->rate_num / p->rate_den * ns / NSEC_PER_SEC /
+		      runtimes[stream].period_size;
+
+	if (got + 1.0 < want || got > want + 1.0)
+		fail("%u period interrupts, %.1f expected", got, want);
+}
+
+/*
+ *  What ALSA does around the driver callbacks
+ */
+
+static const struct snd_pcm_ops *ops(int stream)
+{
+	return emu_pcm->ops[stream];
+}
+
+static int pcm_open(int stream)
+{
+	struct snd_pcm_substream *s = &subs[stream];
+
+	memset(&runtimes[stream], 0, sizeof(runtimes[stream]));
+	memset(&statuses[stream], 0, sizeof(statuses[stream]));
+	s->runtime = &runtimes[stream];
+	s->runtime->status = &statuses[stream];
+	s->pcm = emu_pcm;
+	s->stream = stream;
+	s->private_data = emu_pcm->private_data;
+	return ops(stream)->open(s);
+}
+
+/* The ratnum the ALSA refinement would end up with for rate: one of the seven
+ * 16.9344 MHz divisors or 1058400 / 21..192. */
+static void pick_rate(unsigned int rate, struct snd_pcm_hw_params *p)
+{
+	static const unsigned int divisors[] = { 353, 529, 617, 1058, 1764, 2117, 2558 };
+	unsigned int i;
+	double err, best_err = 1e9;
+
+	for (i = 0; i < ARRAY_SIZE(divisors) + 172; i++) {
+		unsigned int num = i < ARRAY_SIZE(divisors) ? 16934400 : 16934400 / 16;
+		unsigned int den = i < ARRAY_SIZE(divisors) ? divisors[i] :
+				   21 + i - ARRAY_SIZE(divisors);
+
+		err = (double)num / den - rate;
+		if (err < 0)
+			err = -err;
+		if (err < best_err) {
+			best_err = err;
+			p->rate_num = num;
+			p->rate_den = den;
+		}
+	}
+	p->rate = (p->rate_num + p->rate_den / 2) / p->rate_den;
+}
+
+static int pcm_hw_params(int stream, unsigned int rate, unsigned int buffer_bytes,
+			 unsigned int period_bytes)
+{
+	struct snd_pcm_runtime *rt = &runtimes[stream];
+	struct snd_pcm_hw_params *p = &hw_params[stream];
+
+	memset(p, 0, sizeof(*p));
+	pick_rate(rate, p);
+	p->channels = 2;
+	p->format = SNDRV_PCM_FORMAT_S16_LE;
+	rt->rate = p->rate;
+	rt->channels = p->channels;
+	rt->frame_bits = 32;
+	rt->buffer_size = buffer_bytes / 4;
+	rt->period_size = period_bytes / 4;
+	/* below 16 MB and inside one 64 KB page, like the ISA DMA buffers */
+	rt->dma_addr = stream ? 0x210000 : 0x200000;
+	return ops(stream)->hw_params(&subs[stream], p);
+}
+
+/* trigger, pointer and get_time_info run under the stream lock with
+ * interrupts off. */
+static int pcm_trigger(int stream, int cmd)
+{
+	unsigned long flags;
+	int err;
+
+	local_irq_save(flags);
+	err = ops(stream)->trigger(&subs[stream], cmd);
+	local_irq_restore(flags);
+	return err;
+}
+
+static snd_pcm_uframes_t pcm_pointer(int stream)
+{
+	unsigned long flags;
+	snd_pcm_uframes_t pos;
+
+	local_irq_save(flags);
+	pos = ops(stream)->pointer(&subs[stream]);
+	local_irq_restore(flags);
+	return pos;
+}
+
+static int pcm_time_info(int stream, struct snd_pcm_audio_tstamp_report *report)
+{
+	struct snd_pcm_audio_tstamp_config config = {
+		.type_requested = SNDRV_PCM_AUDIO_TSTAMP_TYPE_LINK,
+	};
+	struct timespec64 system_ts, audio_ts;
+	unsigned long flags;
+	int err;
+
+	local_irq_save(flags);
+	err = ops(stream)->get_time_info(&subs[stream], &system_ts, &audio_ts,
+					 &config, report);
+	local_irq_restore(flags);
+	return err;
+}
+
+static int ctl_put(const char *name, long left, long right)
+{
+	struct snd_kcontrol *kctl = emu_ctl_find(name);
+	struct snd_ctl_elem_value value;
+
+	if (!kctl) {
+		fail("no \"%s\" control", name);
+		return -ENOENT;
+	}
+	memset(&value, 0, sizeof(value));
+	value.value.integer.value[0] = left;
+	value.value.integer.value[1] = right;
+	return kctl->new.put(kctl, &value);
+}
+
+/* How far the byte the 8237 reads next is from the start of the buffer. */
+static unsigned int dma_position(int stream)
+{
+	const struct cs4237b_dma *d = &codec.dma[stream ? codec.dma_cap : codec.dma_play];
+
+	return (uint16_t)(d->addr - d->base_addr);
+}
+
+/*
+ *  The scenario
+ */
+
+static unsigned int rate = 48000, buffer_bytes = 16384, period_bytes = 4096;
+
+static void run_checked(int stream, uint64_t ns)
+{
+	struct emu_counters d;
+	uint64_t start = emu_now;
+
+	emu_run(ns);
+	d = op_end();
+	check_periods(stream, d.periods[stream], emu_now - start);
+}
+
+#ifdef CONFIG_PM
+static void suspend_resume(bool lose_codec)
+{
+	op_begin(lose_codec ? "suspend (codec reset)" : "suspend");
+	pcm_trigger(0, SNDRV_PCM_TRIGGER_SUSPEND);
+	chip->suspend(chip);
+	op_end();
+	/* The 8237 always loses its programming; the codec only when the
+	 * 560z cut its power. */
+	cs4237b_dma_reset(&codec);
+	if (lose_codec)
+		cs4237b_reset(&codec, true, SUSPEND_INIT_NS);
+	op_begin(lose_codec ? "resume (codec reset)" : "resume");
+	chip->resume(chip);
+	if (pcm_trigger(0, SNDRV_PCM_TRIGGER_RESUME))
+		fail("RESUME trigger");
+	op_end();
+	check_drift();
+	op_begin("run 200 ms");
+	run_checked(0, 200 * NSEC_PER_MSEC);
+}
+#endif
+
+static void scenario(void)
+{
+	struct snd_pcm_audio_tstamp_report report;
+	struct emu_counters d;
+	unsigned int i, pos, dma, dist;
+	char buf[4096], *line;
+	int err;
+
+	op_begin("probe");
+	err = snd_cs4236_create(&emu_card, CS4237B_PORT, CS4237B_IRQ, CS4237B_DMA1,
+				CS4237B_DMA2, WSS_HW_DETECT, 0, &chip);
+	if (!err)
+		err = snd_cs4236_pcm(chip, 0);
+	if (!err)
+		err = snd_cs4236_mixer(chip);
+	op_end();
+	if (err) {
+		fail("probe returned %d", err);
+		return;
+	}
+
+	op_begin("settle 100 ms");
+	emu_run(100 * NSEC_PER_MSEC);
+	op_end();
+	check_drift();
+
+	op_begin("playback open");
+	if (pcm_open(0))
+		fail("open");
+	op_end();
+
+	op_begin("playback hw_params");
+	if (pcm_hw_params(0, rate, buffer_bytes, period_bytes))
+		fail("hw_params");
+	op_end();
+
+	op_begin("idle 5 ms");
+	emu_run(5 * NSEC_PER_MSEC);
+	op_end();
+
+	op_begin("playback prepare");
+	ops(0)->prepare(&subs[0]);
+	op_end();
+
+	op_begin("playback start");
+	pcm_trigger(0, SNDRV_PCM_TRIGGER_START);
+	op_end();
+
+	op_begin("play 1 s");
+	run_checked(0, NSEC_PER_SEC);
+	check_drift();
+
+	/* poll/avail and the link timestamps of a player */
+	op_begin("pointer x100");
+	for (i = 0; i < 100; i++) {
+		emu_run(NSEC_PER_MSEC);
+		pos = frames_to_bytes(&runtimes[0], pcm_pointer(0));
+		dma = dma_position(0);
+		dist = (dma + buffer_bytes - pos) % buffer_bytes;
+		/* Read from the 8237 or, with interpolate_pointer, behind it
+		 * by less than a period. Never ahead of it by more than the
+		 * FIFO. */
+		if (dist > period_bytes && buffer_bytes - dist > 64)
+			fail("pointer at %u, 8237 at %u", pos, dma);
+	}
+	op_end();
+	op_begin("get_time_info x10");
+	for (i = 0; i < 10; i++) {
+		emu_run(NSEC_PER_MSEC);
+		memset(&report, 0, sizeof(report));
+		if (pcm_time_info(0, &report) ||
+		    report.actual_type != SNDRV_PCM_AUDIO_TSTAMP_TYPE_LINK)
+			fail("no link timestamp");
+	}
+	op_end();
+
+	op_begin("pause push");
+	pcm_trigger(0, SNDRV_PCM_TRIGGER_PAUSE_PUSH);
+	op_end();
+	op_begin("paused 50 ms");
+	emu_run(50 * NSEC_PER_MSEC);
+	d = op_end();
+	if (d.periods[0])
+		fail("%u period interrupts while paused", d.periods[0]);
+	op_begin("pause release");
+	pcm_trigger(0, SNDRV_PCM_TRIGGER_PAUSE_RELEASE);
+	op_end();
+	op_begin("play 200 ms");
+	emu_run(200 * NSEC_PER_MSEC);
+	op_end();
+
+	op_begin("playback stop");
+	pcm_trigger(0, SNDRV_PCM_TRIGGER_STOP);
+	op_end();
+
+	/* Same format again: the driver skips the codec altogether. */
+	op_begin("playback hw_params same");
+	pcm_hw_params(0, rate, buffer_bytes, period_bytes);
+	d = op_end();
+	if (d.codec_in + d.codec_out)
+		fail("%llu codec I/O", (unsigned long long)(d.codec_in + d.codec_out));
+
+	op_begin("capture open");
+	if (pcm_open(1))
+		fail("open");
+	op_end();
+	op_begin("capture hw_params");
+	pcm_hw_params(1, 44100, buffer_bytes, period_bytes);
+	op_end();
+	op_begin("capture prepare");
+	ops(1)->prepare(&subs[1]);
+	op_end();
+	op_begin("capture start");
+	pcm_trigger(1, SNDRV_PCM_TRIGGER_START);
+	op_end();
+	/* Loud enough for the left and right overrange bits of I11. */
+	codec.overrange = 0x0a;
+	op_begin("record 500 ms");
+	run_checked(1, 500 * NSEC_PER_MSEC);
+	if (!runtimes[1].overrange)
+		fail("overrange not counted");
+	codec.overrange = 0;
+	op_begin("capture stop");
+	pcm_trigger(1, SNDRV_PCM_TRIGGER_STOP);
+	op_end();
+	op_begin("capture close");
+	ops(1)->close(&subs[1]);
+	op_end();
+	check_drift();
+
+	/* A slider dragged in alsamixer */
+	op_begin("mixer 200 puts");
+	for (i = 0; i < 100; i++) {
+		ctl_put("Master Digital Volume", i % 72, (i + 1) % 72);
+		ctl_put("PCM Playback Volume", i % 64, (i + 1) % 64);
+		emu_run(100 * NSEC_PER_USEC);
+	}
+	op_end();
+	op_begin("mixer settle 50 ms");
+	emu_run(50 * NSEC_PER_MSEC);
+	op_end();
+	check_drift();
+
+	op_begin("wss_regs read");
+	if (emu_proc_read("wss_regs", buf, sizeof(buf)) <= 0)
+		fail("no wss_regs");
+	op_end();
+	for (line = strtok(buf, "\n"); line; line = strtok(NULL, "\n"))
+		if (strstr(line, "\tdrift") ||
+		    (!strncmp(line, "drift\t", 6) && strcmp(line, "drift\t0")))
+			fail("wss_regs: %s", line);
+	op_begin("wss_regs write");
+	emu_proc_write("wss_regs", "I6 0x3f\nX14 0x10\n");
+	op_end();
+	if (codec.i[6] != 0x3f || codec.x[14] != 0x10)
+		fail("wss_regs write didn't reach the codec");
+	check_drift();
+
+	op_begin("playback prepare");
+	ops(0)->prepare(&subs[0]);
+	pcm_trigger(0, SNDRV_PCM_TRIGGER_START);
+	op_end();
+	op_begin("play 100 ms");
+	run_checked(0, 100 * NSEC_PER_MSEC);
+#ifdef CONFIG_PM
+	suspend_resume(false);
+	suspend_resume(true);
+#endif
+	op_begin("playback stop");
+	pcm_trigger(0, SNDRV_PCM_TRIGGER_STOP);
+	op_end();
+	check_drift();
+
+	op_begin("playback close");
+	ops(0)->close(&subs[0]);
+	op_end();
+	op_begin("settle 100 ms");
+	emu_run(100 * NSEC_PER_MSEC);
+	op_end();
+	check_drift();
+}
+
+static void usage(void)
+{
+	fprintf(stderr,
+		"usage: harness [-c cold|warm] [-p param=value]... [-r rate] [-b buffer bytes]\n"
+		"               [-P period bytes] [-t trace file] [-S] [-v]\n"
+		"  -c  codec as after RESDRV (cold, the default) or left by an earlier load\n"
+		"  -p  module parameter: threaded_irq, interpolate_pointer, master_volume, pcm_volume\n"
+		"  -t  every port access with its time in us, - for stdout\n"
+		"  -S  print /proc/asound/card0/wss_stats at the end\n");
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	bool cold = true, stats = false;
+	char *eq, buf[4096];
+	int c;
+
+	while ((c = getopt(argc, argv, "c:p:r:b:P:t:Sv")) != -1) {
+		switch (c) {
+		case 'c':
+			cold = strcmp(optarg, "warm");
+			break;
+		case 'p':
+			eq = strchr(optarg, '=');
+			if (!eq)
+				usage();
+			*eq = '\0';
+			if (emu_param_set(optarg, eq + 1)) {
+				fprintf(stderr, "no parameter %s\n", optarg);
+				return 2;
+			}
+			break;
+		case 'r':
+			rate = atoi(optarg);
+			break;
+		case 'b':
+			buffer_bytes = atoi(optarg);
+			break;
+		case 'P':
+			period_bytes = atoi(optarg);
+			break;
+		case 't':
+			emu_trace = strcmp(optarg, "-") ? fopen(optarg, "w") : stdout;
+			if (!emu_trace) {
+				perror(optarg);
+				return 2;
+			}
+			break;
+		case 'S':
+			stats = true;
+			break;
+		case 'v':
+			emu_verbose = 1;
+			break;
+		default:
+			usage();
+		}
+	}
+	if (!period_bytes || buffer_bytes % period_bytes || buffer_bytes > 65536)
+		usage();
+
+	/* The 560z has been up a second when the driver loads. */
+	emu_now = NSEC_PER_SEC;
+	cs4237b_reset(&codec, cold, 0);
+
+	printf("# CS4237B model, %s codec, %u Hz, %u/%u byte buffer/period\n",
+	       cold ? "cold" : "warm", rate, buffer_bytes, period_bytes);
+	printf("# simulated: %u ns per ISA I/O, HZ=%u; times are not 560z measurements\n",
+	       CS4237B_IO_NS, HZ);
+	printf("%-24s %6s %6s %5s %8s %8s %7s %5s %5s %8s %3s\n", "operation", "in", "out",
+	       "dma", "udelay", "sleep", "irqoff", "irqs", "per", "ms", "flt");
+	scenario();
+	if (stats && chip && emu_proc_read("wss_stats", buf, sizeof(buf)) > 0)
+		fputs(buf, stdout);
+
+	op_begin("remove");
+	emu_devm_release();
+	op_end();
+
+	printf("# %u calibrations, %.3f s simulated\n", codec.calibrations, emu_now / 1e9);
+	if (cs4237b_fault_count(&codec))
+		cs4237b_print_faults(&codec, stdout);
+	if (emu_trace && emu_trace != stdout)
+		fclose(emu_trace);
+	puts(failed ? "FAIL" : "ok");
+	return failed;
+}
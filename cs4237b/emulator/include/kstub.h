@@ -0,0 +1,356 @@
+/*
+ * Copyright (C) 2026  linic@hotmail.ca Subject to GPL-3.0 license.
+ * https://github.com/linic/tcl-core-560z
+ *
+ * Just enough of the kernel for wss_lib.c, cs4236_lib.c and cs4236.c to build
+ * as ordinary userspace C. Every linux/ and asm/ header of this directory is
+ * this file. What only needs to compile is a macro or a prototype; what the
+ * driver relies on at run time (delays, locks, work, port I/O) is implemented
+ * in ../kernel.c on top of the simulated clock of ../cs4237b.c.
+ */
+#ifndef KSTUB_H
+#define KSTUB_H
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+typedef uint8_t u8; typedef uint16_t u16; typedef uint32_t u32; typedef unsigned long long u64;
+typedef int8_t s8; typedef int16_t s16; typedef int32_t s32; typedef int64_t s64;
+typedef long long ktime_t; typedef unsigned int gfp_t; typedef long loff_t;
+typedef unsigned long dma_addr_t; typedef unsigned long resource_size_t;
+typedef int snd_pcm_format_t; typedef long snd_pcm_sframes_t; typedef unsigned long snd_pcm_uframes_t;
+typedef int irqreturn_t; typedef irqreturn_t (*irq_handler_t)(int, void *);
+#define IRQ_NONE 0
+#define IRQ_HANDLED 1
+#define IRQ_WAKE_THREAD 2
+#define IRQF_ONESHOT 0x2000
+#define IRQF_SHARED 0x80
+#define __iomem
+#define __init
+#define __exit
+#define __user
+#define __must_check
+#define __maybe_unused __attribute__((unused))
+#define __always_unused __attribute__((unused))
+#define __printf(a,b) __attribute__((format(printf, a, b)))
+#define __rcu
+#define __bitwise
+#define likely(x) (x)
+#define unlikely(x) (x)
+#define fallthrough __attribute__((fallthrough))
+#define GFP_KERNEL 0
+#define EXPORT_SYMBOL(x) extern int __export_##x
+#define EXPORT_SYMBOL_GPL(x) extern int __export_##x
+#define MODULE_AUTHOR(x)
+#define MODULE_DESCRIPTION(x)
+#define MODULE_LICENSE(x)
+#define MODULE_DEVICE_TABLE(a,b)
+#define MODULE_ALIAS(x)
+#define MODULE_PARM_DESC(a,b)
+/* Module parameters register themselves so the harness can set them with -p. */
+void emu_param_register(const char *name, void *var, size_t size);
+#define module_param_named(n, v, t, p) \
+	static void __attribute__((constructor)) __emu_param_##n(void) \
+	{ emu_param_register(#n, &(v), sizeof(v)); }
+#define module_param(n, t, p) module_param_named(n, n, t, p)
+#define module_param_array(a,b,c,d) extern int __mpa_##a
+#define module_param_hw_array(a,b,c,d,e) extern int __mpa_##a
+#define module_init(x) int __mi(void){return x();}
+#define module_exit(x) void __me(void){x();}
+#define THIS_MODULE ((void *)0)
+#define ARRAY_SIZE(a) (sizeof(a)/sizeof((a)[0]))
+#define BIT(n) (1UL << (n))
+#define GENMASK(h,l) (((~0U) << (l)) & (~0U >> (31 - (h))))
+#define BITS_PER_LONG 32
+#define DECLARE_BITMAP(n,b) unsigned long n[((b)+31)/32]
+#define min(a,b) ((a)<(b)?(a):(b))
+#define max(a,b) ((a)>(b)?(a):(b))
+#define min_t(t,a,b) ((t)(a)<(t)(b)?(t)(a):(t)(b))
+#define max_t(t,a,b) ((t)(a)>(t)(b)?(t)(a):(t)(b))
+#define clamp(v,a,b) min(max(v,a),b)
+#define clamp_val(v,a,b) clamp(v,a,b)
+#define container_of(p,t,m) ((t *)((char *)(p) - offsetof(t,m)))
+#define READ_ONCE(x) (x)
+#define WRITE_ONCE(x,v) ((x) = (v))
+#define IS_ENABLED(x) __is_enabled(x)
+#define __is_enabled(x) ___is_enabled(__ARG_PLACEHOLDER_##x)
+#define __ARG_PLACEHOLDER_1 0,
+#define ___is_enabled(arg) ____is_enabled(arg 1, 0)
+#define ____is_enabled(ignored, val, ...) val
+/* messages */
+void emu_printk(int level, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+#define EMU_LOG_ERR	0
+#define EMU_LOG_WARN	1
+#define EMU_LOG_INFO	2
+#define EMU_LOG_DBG	3
+#define pr_info(...) emu_printk(EMU_LOG_INFO, __VA_ARGS__)
+#define pr_debug(...) emu_printk(EMU_LOG_DBG, __VA_ARGS__)
+#define pr_err(...) emu_printk(EMU_LOG_ERR, __VA_ARGS__)
+#define pr_warn(...) emu_printk(EMU_LOG_WARN, __VA_ARGS__)
+#define printk(...) emu_printk(EMU_LOG_INFO, __VA_ARGS__)
+/* printk levels as in the kernel, emu_printk reads them */
+#define KERN_ERR "\0013"
+#define KERN_WARNING "\0014"
+#define KERN_DEBUG "\0017"
+#define dev_err(d, ...) ((void)(d), emu_printk(EMU_LOG_ERR, __VA_ARGS__))
+#define dev_warn(d, ...) ((void)(d), emu_printk(EMU_LOG_WARN, __VA_ARGS__))
+#define dev_info(d, ...) ((void)(d), emu_printk(EMU_LOG_INFO, __VA_ARGS__))
+#define dev_dbg(d, ...) ((void)(d), emu_printk(EMU_LOG_DBG, __VA_ARGS__))
+#define dev_notice(d, ...) dev_info(d, __VA_ARGS__)
+#define dev_err_ratelimited(d, ...) dev_err(d, __VA_ARGS__)
+#define dev_warn_ratelimited(d, ...) dev_warn(d, __VA_ARGS__)
+#define dev_dbg_ratelimited(d, ...) dev_dbg(d, __VA_ARGS__)
+#define dev_warn_once(d, ...) dev_warn(d, __VA_ARGS__)
+#define snd_printk(...) emu_printk(EMU_LOG_INFO, __VA_ARGS__)
+#define snd_printdd(...) emu_printk(EMU_LOG_DBG, __VA_ARGS__)
+#define snd_printd(...) emu_printk(EMU_LOG_DBG, __VA_ARGS__)
+void emu_bug(const char *what, const char *file, int line);
+#define WARN_ON(x) ({ bool __w = (x); if (__w) emu_bug("WARN_ON(" #x ")", __FILE__, __LINE__); __w; })
+#define BUG_ON(x) ((void)WARN_ON(x))
+#define snd_BUG_ON(x) WARN_ON(x)
+#define snd_BUG() emu_bug("snd_BUG()", __FILE__, __LINE__)
+#define BUILD_BUG_ON(x) _Static_assert(!(x), "bug")
+#define ENODEV 19
+#define EBUSY 16
+#define EINVAL 22
+#define ENOMEM 12
+#define EIO 5
+#define ENXIO 6
+#define ETIMEDOUT 110
+#define EAGAIN 11
+#define ENOENT 2
+#define ERESTARTSYS 512
+#define MAX_ERRNO 4095
+#define IS_ERR(p) ((unsigned long)(p) >= (unsigned long)-MAX_ERRNO)
+#define PTR_ERR(p) ((long)(p))
+#define IS_ERR_OR_NULL(p) (!(p) || IS_ERR(p))
+#define ERR_PTR(e) ((void *)(long)(e))
+/* time: HZ and the ISA timing are the ones of the 560z kernel */
+#define HZ 300
+#define USEC_PER_SEC 1000000L
+#define NSEC_PER_USEC 1000L
+#define NSEC_PER_MSEC 1000000L
+#define NSEC_PER_SEC 1000000000L
+#define do_div(n,b) ({ unsigned int __r = (n) % (b); (n) /= (b); __r; })
+#define div_u64(a,b) ((u64)(a)/(b))
+#define DIV_ROUND_UP(a,b) (((a)+(b)-1)/(b))
+#define rounddown_pow_of_two(x) (x)
+#define time_after(a,b) ((long)((b) - (a)) < 0)
+#define time_before(a,b) time_after(b,a)
+#define time_after_eq(a,b) ((long)((a) - (b)) >= 0)
+#define time_before_eq(a,b) time_after_eq(b,a)
+extern volatile unsigned long jiffies;
+unsigned long msecs_to_jiffies(unsigned int);
+unsigned long usecs_to_jiffies(unsigned int);
+unsigned int jiffies_to_msecs(unsigned long);
+unsigned int jiffies_to_usecs(unsigned long);
+ktime_t ktime_get(void); ktime_t ktime_get_raw(void); ktime_t ktime_get_boottime(void);
+u64 ktime_get_ns(void); u64 local_clock(void);
+#define ktime_sub(a,b) ((a)-(b))
+#define ktime_add_ns(a,n) ((a)+(n))
+#define ktime_to_ns(a) (a)
+#define ktime_to_us(a) ((a)/1000)
+#define ns_to_ktime(n) ((ktime_t)(n))
+#define ktime_us_delta(a,b) (((a)-(b))/1000)
+struct timespec64 { long long tv_sec; long tv_nsec; };
+struct timespec64 ns_to_timespec64(s64);
+#define ktime_to_timespec64(k) ns_to_timespec64(k)
+void udelay(unsigned long); void ndelay(unsigned long); void mdelay(unsigned long);
+void msleep(unsigned int); void usleep_range(unsigned long, unsigned long);
+void fsleep(unsigned long); void cpu_relax(void); void might_sleep(void);
+int schedule_timeout_uninterruptible(long); int schedule_timeout_interruptible(long);
+/* Same loop as include/linux/iopoll.h: sleep_us between reads, one last read
+ * after the timeout. */
+#define read_poll_timeout(op, val, cond, sleep_us, timeout_us, sleep_before_read, args...) \
+({ \
+	u64 __timeout_us = (timeout_us); \
+	unsigned long __sleep_us = (sleep_us); \
+	u64 __end = local_clock() + __timeout_us * NSEC_PER_USEC; \
+	might_sleep_if(__sleep_us); \
+	if ((sleep_before_read) && __sleep_us) \
+		usleep_range((__sleep_us >> 2) + 1, __sleep_us); \
+	for (;;) { \
+		(val) = op(args); \
+		if (cond) \
+			break; \
+		if (__timeout_us && local_clock() > __end) { \
+			(val) = op(args); \
+			break; \
+		} \
+		if (__sleep_us) \
+			usleep_range((__sleep_us >> 2) + 1, __sleep_us); \
+		cpu_relax(); \
+	} \
+	(cond) ? 0 : -ETIMEDOUT; \
+})
+#define readx_poll_timeout(op, addr, val, cond, sleep_us, timeout_us) \
+	read_poll_timeout(op, val, cond, sleep_us, timeout_us, false, addr)
+#define might_sleep_if(c) do { if (c) might_sleep(); } while (0)
+void mb(void); void rmb(void); void wmb(void); void barrier(void); void smp_mb(void);
+/* port I/O, routed to the model */
+unsigned char inb(unsigned long); void outb(unsigned char, unsigned long);
+unsigned short inw(unsigned long); void outw(unsigned short, unsigned long);
+void *kzalloc(size_t, gfp_t); void *kmalloc(size_t, gfp_t); void *kcalloc(size_t,size_t,gfp_t); void kfree(const void *);
+void *kmemdup(const void *, size_t, gfp_t);
+#define strscpy(d, s, ...) ((size_t)snprintf((d), sizeof(d), "%s", (s)))
+int scnprintf(char *, size_t, const char *, ...);
+int kstrtouint(const char *, unsigned int, unsigned int *);
+int kstrtoul(const char *, unsigned int, unsigned long *);
+char *strim(char *); char *skip_spaces(const char *);
+#define hweight8(w) __builtin_popcount((u8)(w))
+#define hweight32(w) __builtin_popcount((u32)(w))
+#define hweight_long(w) __builtin_popcountl(w)
+int fls(unsigned int); unsigned long __ffs(unsigned long);
+void set_bit(int, volatile unsigned long *); void clear_bit(int, volatile unsigned long *);
+void __set_bit(int, volatile unsigned long *); void __clear_bit(int, volatile unsigned long *);
+int test_bit(int, const volatile unsigned long *); int test_and_clear_bit(int, volatile unsigned long *);
+int test_and_set_bit(int, volatile unsigned long *);
+int __test_and_clear_bit(int, volatile unsigned long *);
+void bitmap_zero(unsigned long *, unsigned int); int bitmap_empty(const unsigned long *, unsigned int);
+unsigned long find_first_bit(const unsigned long *, unsigned long);
+unsigned long find_next_bit(const unsigned long *, unsigned long, unsigned long);
+#define for_each_set_bit(bit, addr, size) \
+	for ((bit) = find_first_bit((addr), (size)); (bit) < (size); (bit) = find_next_bit((addr), (size), (bit) + 1))
+typedef struct { int counter; } atomic_t;
+typedef struct { long counter; } atomic_long_t;
+int atomic_read(const atomic_t *); void atomic_set(atomic_t *, int); void atomic_inc(atomic_t *);
+int atomic_inc_return(atomic_t *); void atomic_add(int, atomic_t *);
+/* locking: one CPU, so a lock only records who holds it. Taking a held lock
+ * or sleeping with interrupts off is reported and fails the run. */
+typedef struct { int locked; } spinlock_t;
+struct mutex { int locked; };
+struct lock_class_key { int x; };
+void spin_lock_init(spinlock_t *); void mutex_init(struct mutex *);
+void spin_lock(spinlock_t *); void spin_unlock(spinlock_t *);
+void spin_lock_irq(spinlock_t *); void spin_unlock_irq(spinlock_t *);
+unsigned long emu_spin_lock_irqsave(spinlock_t *);
+#define spin_lock_irqsave(l,f) do { (f) = emu_spin_lock_irqsave(l); } while (0)
+void spin_unlock_irqrestore(spinlock_t *, unsigned long);
+void mutex_lock(struct mutex *); void mutex_unlock(struct mutex *); int mutex_trylock(struct mutex *);
+int mutex_is_locked(struct mutex *);
+#define DEFINE_MUTEX(n) struct mutex n
+#define lockdep_assert_held(l) WARN_ON(!(l)->locked)
+unsigned long emu_local_irq_save(void);
+#define local_irq_save(f) do { (f) = emu_local_irq_save(); } while (0)
+void local_irq_restore(unsigned long);
+struct __guard_spinlock { spinlock_t *l; int done; };
+struct __guard_spinlock_irq { spinlock_t *l; int done; };
+struct __guard_spinlock_irqsave { spinlock_t *l; int done; unsigned long flags; };
+struct __guard_mutex { struct mutex *l; int done; };
+void __guard_spinlock_exit(struct __guard_spinlock *);
+void __guard_spinlock_irq_exit(struct __guard_spinlock_irq *);
+void __guard_spinlock_irqsave_exit(struct __guard_spinlock_irqsave *);
+void __guard_mutex_exit(struct __guard_mutex *);
+#define __KS_CAT2(a,b) a##b
+#define __KS_CAT(a,b) __KS_CAT2(a,b)
+struct __guard_spinlock __guard_spinlock_init(spinlock_t *);
+struct __guard_spinlock_irq __guard_spinlock_irq_init(spinlock_t *);
+struct __guard_spinlock_irqsave __guard_spinlock_irqsave_init(spinlock_t *);
+struct __guard_mutex __guard_mutex_init(struct mutex *);
+#define guard(name) struct __guard_##name __attribute__((cleanup(__guard_##name##_exit))) __KS_CAT(__g, __COUNTER__) = __guard_##name##_init
+/* The body runs exactly once and the compiler can see it from __sg_once, so
+ * whatever it assigns counts as initialized after the scope, like with the
+ * kernel's class guards. A break leaves both loops. */
+#define scoped_guard(name, lock) \
+	for (int __sg_once = 1; __sg_once; __sg_once = 0) \
+		for (struct __guard_##name __attribute__((cleanup(__guard_##name##_exit))) \
+		     __sg = __guard_##name##_init(lock); __sg_once; __sg_once = 0)
+/* wait/completion/work: work runs when the harness lets time pass or when
+ * something waits for it. */
+typedef struct { int x; } wait_queue_head_t;
+void init_waitqueue_head(wait_queue_head_t *); void wake_up(wait_queue_head_t *);
+struct completion { int done; };
+void init_completion(struct completion *); void reinit_completion(struct completion *);
+void complete(struct completion *); void complete_all(struct completion *);
+void wait_for_completion(struct completion *);
+unsigned long wait_for_completion_timeout(struct completion *, unsigned long);
+bool completion_done(struct completion *);
+/* due is in jiffies; delayed work only runs when the harness lets time pass. */
+struct work_struct { int pending; int delayed; unsigned long due; struct work_struct *next;
+	void (*func)(struct work_struct *); };
+struct timer_list { int x; void (*function)(struct timer_list *); unsigned long expires; };
+struct delayed_work { struct work_struct work; struct timer_list timer; };
+#define INIT_WORK(w,f) ((w)->func = (f), (w)->pending = 0, (w)->delayed = 0, (w)->next = NULL)
+#define INIT_DELAYED_WORK(w,f) (INIT_WORK(&(w)->work, f), (w)->work.delayed = 1)
+bool schedule_work(struct work_struct *); bool schedule_delayed_work(struct delayed_work *, unsigned long);
+bool emu_mod_delayed_work(struct delayed_work *, unsigned long);
+#define mod_delayed_work(wq, w, d) emu_mod_delayed_work(w, d)
+bool cancel_work_sync(struct work_struct *); bool cancel_delayed_work_sync(struct delayed_work *);
+bool cancel_delayed_work(struct delayed_work *);
+bool flush_work(struct work_struct *); bool flush_delayed_work(struct delayed_work *);
+bool work_pending(struct work_struct *); bool delayed_work_pending(struct delayed_work *);
+#define system_wq ((void *)0)
+#define to_delayed_work(w) container_of(w, struct delayed_work, work)
+void timer_setup_f(struct timer_list *, void (*)(struct timer_list *), unsigned int);
+#define timer_setup(t,f,fl) timer_setup_f(t,f,fl)
+int mod_timer(struct timer_list *, unsigned long); int timer_delete_sync(struct timer_list *);
+int timer_delete(struct timer_list *);
+#define from_timer(var, t, field) container_of(t, typeof(*var), field)
+#define timer_container_of(var, t, field) container_of(t, typeof(*var), field)
+/* devices */
+struct device { void *driver_data; };
+struct device_driver { const char *name; int probe_type; void *pm; };
+#define PROBE_PREFER_ASYNCHRONOUS 1
+#define PROBE_DEFAULT_STRATEGY 0
+void *dev_get_drvdata(const struct device *); void dev_set_drvdata(struct device *, void *);
+struct resource { resource_size_t start, end; };
+struct resource *devm_request_region(struct device *, unsigned long, unsigned long, const char *);
+int devm_request_irq(struct device *, unsigned int, irq_handler_t, unsigned long, const char *, void *);
+int devm_request_threaded_irq(struct device *, unsigned int, irq_handler_t, irq_handler_t, unsigned long, const char *, void *);
+int devm_add_action_or_reset(struct device *, void (*)(void *), void *);
+void *devm_kzalloc(struct device *, size_t, gfp_t);
+/* source-4, -5 and -6 */
+struct resource *request_region(unsigned long, unsigned long, const char *);
+void release_and_free_resource(struct resource *);
+int request_irq(unsigned int, irq_handler_t, unsigned long, const char *, void *);
+void free_irq(unsigned int, void *);
+int request_dma(unsigned int, const char *); void free_dma(unsigned int);
+void synchronize_irq(unsigned int); void disable_irq(unsigned int); void enable_irq(unsigned int);
+typedef struct { int event; } pm_message_t;
+#define PMSG_SUSPEND ((pm_message_t){1})
+struct isa_driver { int (*match)(struct device *, unsigned int); int (*probe)(struct device *, unsigned int);
+	int (*suspend)(struct device *, unsigned int, pm_message_t); int (*resume)(struct device *, unsigned int);
+	struct device_driver driver; };
+int isa_register_driver(struct isa_driver *, unsigned int); void isa_unregister_driver(struct isa_driver *);
+/* pnp, only for cs4236.c which is syntax-checked, not run */
+struct pnp_id { char id[8]; };
+struct list_head { struct list_head *next, *prev; };
+#define list_for_each_entry(pos, head, member) for (pos = container_of((head)->next, typeof(*pos), member); &pos->member != (head); pos = container_of(pos->member.next, typeof(*pos), member))
+struct pnp_protocol { const char *name; struct list_head devices; };
+struct pnp_dev { struct device dev; struct list_head protocol_list; void *data; const char *name; struct pnp_id *id; struct pnp_protocol *protocol; };
+struct pnp_card { struct device dev; };
+struct pnp_card_link { void *data; struct pnp_card *card; };
+int pnp_device_is_isapnp(struct pnp_dev *);
+struct pnp_device_id { const char *id; unsigned long driver_data; };
+struct pnp_card_device_id { const char *id; unsigned long driver_data; struct { const char *id; } devs[8]; };
+struct pnp_driver { const char *name; const struct pnp_device_id *id_table; unsigned int flags;
+	int (*probe)(struct pnp_dev *, const struct pnp_device_id *); void (*remove)(struct pnp_dev *);
+	int (*suspend)(struct pnp_dev *, pm_message_t); int (*resume)(struct pnp_dev *); struct device_driver driver; };
+struct pnp_card_driver { const char *name; const struct pnp_card_device_id *id_table; unsigned int flags;
+	int (*probe)(struct pnp_card_link *, const struct pnp_card_device_id *); void (*remove)(struct pnp_card_link *);
+	int (*suspend)(struct pnp_card_link *, pm_message_t); int (*resume)(struct pnp_card_link *); struct pnp_driver link; };
+#define PNP_DRIVER_RES_DISABLE 3
+int pnp_register_driver(struct pnp_driver *); void pnp_unregister_driver(struct pnp_driver *);
+int pnp_register_card_driver(struct pnp_card_driver *); void pnp_unregister_card_driver(struct pnp_card_driver *);
+struct pnp_dev *pnp_request_card_device(struct pnp_card_link *, const char *, struct pnp_dev *);
+int pnp_activate_dev(struct pnp_dev *);
+unsigned long pnp_port_start(struct pnp_dev *, unsigned int); unsigned long pnp_port_len(struct pnp_dev *, unsigned int);
+int pnp_port_valid(struct pnp_dev *, unsigned int);
+int pnp_irq(struct pnp_dev *, unsigned int); int pnp_irq_valid(struct pnp_dev *, unsigned int);
+int pnp_dma(struct pnp_dev *, unsigned int); int pnp_dma_valid(struct pnp_dev *, unsigned int);
+void *pnp_get_drvdata(struct pnp_dev *); void pnp_set_drvdata(struct pnp_dev *, void *);
+void *pnp_get_card_drvdata(struct pnp_card_link *); void pnp_set_card_drvdata(struct pnp_card_link *, void *);
+const char *dev_name(const struct device *);
+/* 8237 DMA controller, asm/dma.h. These go through inb/outb like the real ones. */
+#define DMA_MODE_READ 0x44
+#define DMA_MODE_WRITE 0x48
+#define DMA_AUTOINIT 0x10
+#define DMA_MODE_NO_ENABLE 0x100
+unsigned long claim_dma_lock(void); void release_dma_lock(unsigned long);
+void disable_dma(unsigned int); void enable_dma(unsigned int); void clear_dma_ff(unsigned int);
+void set_dma_mode(unsigned int, char); void set_dma_addr(unsigned int, unsigned int);
+void set_dma_count(unsigned int, unsigned int); int get_dma_residue(unsigned int);
+struct proc_dir_entry;
+struct seq_file;
+#endif
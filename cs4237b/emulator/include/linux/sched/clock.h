@@ -0,0 +1 @@
+#include "../../kstub.h"
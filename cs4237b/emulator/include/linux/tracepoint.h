@@ -0,0 +1,22 @@
+#include "../kstub.h"
+#ifndef KSTUB_TRACEPOINT
+#define KSTUB_TRACEPOINT
+/* type-checks TP_fast_assign and TP_printk bodies; trace calls do nothing */
+#define TP_PROTO(...) __VA_ARGS__
+#define TP_ARGS(...) __VA_ARGS__
+#define TP_STRUCT__entry(...) __VA_ARGS__
+#define TP_fast_assign(...) __VA_ARGS__
+#define __field(t, n) t n;
+#define __entry __e
+#define TP_printk(fmt, ...) __kstub_tp_printf(fmt, __VA_ARGS__)
+int __kstub_tp_printf(const char *, ...) __attribute__((format(printf, 1, 2)));
+#define DECLARE_EVENT_CLASS(name, proto, args, tstruct, assign, print) \
+	struct trace_event_raw_##name { tstruct }; \
+	static inline void __trace_class_##name(proto) { struct trace_event_raw_##name *__e = 0; if (0) { assign print; } }
+#define DEFINE_EVENT(template, name, proto, args) \
+	static inline void trace_##name(proto) { if (0) __trace_class_##template(args); } \
+	static inline _Bool trace_##name##_enabled(void) { return 0; }
+#define TRACE_EVENT(name, proto, args, tstruct, assign, print) \
+	DECLARE_EVENT_CLASS(name, TP_PROTO(proto), TP_ARGS(args), TP_STRUCT__entry(tstruct), TP_fast_assign(assign), print) \
+	DEFINE_EVENT(name, name, TP_PROTO(proto), TP_ARGS(args))
+#endif
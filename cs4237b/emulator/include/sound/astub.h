@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2026  linic@hotmail.ca Subject to GPL-3.0 license.
+ * https://github.com/linic/tcl-core-560z
+ *
+ * The part of ALSA the driver sees, for the emulator. Every sound/ header of
+ * this directory except cs4231-regs.h is this file. The structures only have
+ * the fields the driver and ../kernel.c use.
+ */
+#ifndef ASTUB_H
+#define ASTUB_H
+#include "../kstub.h"
+#define SNDRV_CARDS 8
+#define SNDRV_AUTO_PORT 1
+#define SNDRV_AUTO_IRQ 0xffff
+#define SNDRV_AUTO_DMA 0xffff
+#define SNDRV_DEFAULT_IDX { [0 ... (SNDRV_CARDS-1)] = -1 }
+#define SNDRV_DEFAULT_STR { [0 ... (SNDRV_CARDS-1)] = NULL }
+#define SNDRV_DEFAULT_ENABLE_ISAPNP { [0 ... (SNDRV_CARDS-1)] = 1 }
+#define SNDRV_DEFAULT_PORT { [0 ... (SNDRV_CARDS-1)] = SNDRV_AUTO_PORT }
+#define SNDRV_DEFAULT_IRQ { [0 ... (SNDRV_CARDS-1)] = SNDRV_AUTO_IRQ }
+#define SNDRV_DEFAULT_DMA { [0 ... (SNDRV_CARDS-1)] = SNDRV_AUTO_DMA }
+#define SNDRV_CTL_POWER_D0 0
+#define SNDRV_CTL_POWER_D3 0x400
+#define SNDRV_CTL_POWER_D3hot 0x400
+#define SNDRV_DMA_TYPE_DEV 2
+struct snd_card { int number; char id[16]; char driver[16]; char shortname[32]; char longname[80];
+	char mixername[80]; void *private_data; struct device *dev; int sync_irq; };
+int snd_devm_card_new(struct device *, int, const char *, void *, size_t, struct snd_card **);
+int snd_card_register(struct snd_card *);
+void snd_power_change_state(struct snd_card *, unsigned int);
+int snd_devm_request_dma(struct device *, int, const char *);
+struct snd_info_entry;
+struct snd_info_buffer;
+typedef void (*snd_info_read_t)(struct snd_info_entry *, struct snd_info_buffer *);
+typedef void (*snd_info_write_t)(struct snd_info_entry *, struct snd_info_buffer *);
+struct snd_info_entry { void *private_data; const char *name; snd_info_read_t read; snd_info_write_t write; };
+int snd_card_ro_proc_new(struct snd_card *, const char *, void *, snd_info_read_t);
+int snd_card_rw_proc_new(struct snd_card *, const char *, void *, snd_info_read_t, snd_info_write_t);
+void snd_iprintf(struct snd_info_buffer *, const char *, ...);
+int snd_info_get_line(struct snd_info_buffer *, char *, int);
+const char *snd_info_get_str(char *, const char *, int);
+/* dma */
+void snd_dma_program(unsigned long, unsigned long, unsigned int, unsigned short);
+void snd_dma_disable(unsigned long);
+unsigned int snd_dma_pointer(unsigned long, unsigned int);
+/* pcm */
+#define SNDRV_PCM_STREAM_PLAYBACK 0
+#define SNDRV_PCM_STREAM_CAPTURE 1
+#define SNDRV_PCM_INFO_MMAP 0x1
+#define SNDRV_PCM_INFO_MMAP_VALID 0x2
+#define SNDRV_PCM_INFO_INTERLEAVED 0x100
+#define SNDRV_PCM_INFO_PAUSE 0x80000
+#define SNDRV_PCM_INFO_RESUME 0x40000
+#define SNDRV_PCM_INFO_SYNC_START 0x400000
+#define SNDRV_PCM_INFO_NO_PERIOD_WAKEUP 0x800000
+#define SNDRV_PCM_INFO_HAS_LINK_ATIME 0x1000000
+#define SNDRV_PCM_INFO_HAS_LINK_ABSOLUTE_ATIME 0x2000000
+#define SNDRV_PCM_INFO_HAS_WALL_CLOCK 0x1000000
+#define SNDRV_PCM_INFO_JOINT_DUPLEX 0x200000
+#define SNDRV_PCM_TRIGGER_STOP 0
+#define SNDRV_PCM_TRIGGER_START 1
+#define SNDRV_PCM_TRIGGER_PAUSE_PUSH 3
+#define SNDRV_PCM_TRIGGER_PAUSE_RELEASE 4
+#define SNDRV_PCM_TRIGGER_SUSPEND 5
+#define SNDRV_PCM_TRIGGER_RESUME 6
+#define SNDRV_PCM_STATE_OPEN 0
+#define SNDRV_PCM_STATE_SETUP 1
+#define SNDRV_PCM_STATE_PREPARED 2
+#define SNDRV_PCM_STATE_RUNNING 3
+#define SNDRV_PCM_STATE_XRUN 4
+#define SNDRV_PCM_STATE_PAUSED 6
+#define SNDRV_PCM_STATE_SUSPENDED 7
+#define SNDRV_PCM_FORMAT_U8 1
+#define SNDRV_PCM_FORMAT_S16_LE 2
+#define SNDRV_PCM_FORMAT_S16_BE 3
+#define SNDRV_PCM_FORMAT_MU_LAW 20
+#define SNDRV_PCM_FORMAT_A_LAW 21
+#define SNDRV_PCM_FORMAT_IMA_ADPCM 22
+#define SNDRV_PCM_FMTBIT_U8 (1ULL<<1)
+#define SNDRV_PCM_FMTBIT_S16_LE (1ULL<<2)
+#define SNDRV_PCM_FMTBIT_S16_BE (1ULL<<3)
+#define SNDRV_PCM_FMTBIT_MU_LAW (1ULL<<20)
+#define SNDRV_PCM_FMTBIT_A_LAW (1ULL<<21)
+#define SNDRV_PCM_FMTBIT_IMA_ADPCM (1ULL<<22)
+#define SNDRV_PCM_RATE_KNOT (1<<31)
+#define SNDRV_PCM_RATE_8000_48000 0x1ff
+#define SNDRV_PCM_HW_PARAM_RATE 11
+#define SNDRV_PCM_AUDIO_TSTAMP_TYPE_COMPAT 0
+#define SNDRV_PCM_AUDIO_TSTAMP_TYPE_DEFAULT 1
+#define SNDRV_PCM_AUDIO_TSTAMP_TYPE_LINK 2
+#define SNDRV_PCM_AUDIO_TSTAMP_TYPE_LINK_ABSOLUTE 3
+#define SNDRV_PCM_AUDIO_TSTAMP_TYPE_LINK_ESTIMATED 4
+#define SNDRV_PCM_AUDIO_TSTAMP_TYPE_LINK_SYNCHRONIZED 5
+#define SNDRV_PCM_TSTAMP_TYPE_MONOTONIC_RAW 2
+struct snd_pcm_hardware { unsigned int info; u64 formats; unsigned int rates, rate_min, rate_max, channels_min, channels_max;
+	size_t buffer_bytes_max, period_bytes_min, period_bytes_max; unsigned int periods_min, periods_max; size_t fifo_size; };
+struct snd_pcm_audio_tstamp_config { u32 type_requested:4; u32 report_delay:1; };
+struct snd_pcm_audio_tstamp_report { u32 valid:1; u32 actual_type:4; u32 accuracy_report:1; u32 accuracy; };
+struct snd_pcm_status_stub { int x; };
+struct snd_pcm_mmap_status { snd_pcm_uframes_t hw_ptr; };
+struct snd_pcm_runtime { struct snd_pcm_mmap_status *status; snd_pcm_uframes_t hw_ptr_base; int state; struct snd_pcm_hardware hw; unsigned long dma_addr; unsigned int rate, channels;
+	snd_pcm_uframes_t buffer_size, period_size; unsigned int overrange; int no_period_wakeup;
+	struct snd_pcm_audio_tstamp_config audio_tstamp_config; struct snd_pcm_audio_tstamp_report audio_tstamp_report;
+	int tstamp_type; void *private_data; snd_pcm_uframes_t delay; unsigned int frame_bits; };
+struct snd_pcm;
+struct snd_pcm_substream { struct snd_pcm_runtime *runtime; struct snd_pcm *pcm; int stream; void *private_data; };
+struct snd_pcm_hw_params { unsigned int rate_num, rate_den; unsigned int rate, channels; int format; };
+struct snd_pcm_ops { int (*open)(struct snd_pcm_substream *); int (*close)(struct snd_pcm_substream *);
+	int (*hw_params)(struct snd_pcm_substream *, struct snd_pcm_hw_params *); int (*hw_free)(struct snd_pcm_substream *);
+	int (*prepare)(struct snd_pcm_substream *); int (*trigger)(struct snd_pcm_substream *, int);
+	snd_pcm_uframes_t (*pointer)(struct snd_pcm_substream *);
+	int (*get_time_info)(struct snd_pcm_substream *, struct timespec64 *, struct timespec64 *,
+		struct snd_pcm_audio_tstamp_config *, struct snd_pcm_audio_tstamp_report *);
+	int (*ioctl)(struct snd_pcm_substream *, unsigned int, void *); };
+struct snd_pcm { struct snd_card *card; char name[80]; unsigned int info_flags; void *private_data;
+	const struct snd_pcm_ops *ops[2]; };
+int snd_pcm_new(struct snd_card *, const char *, int, int, int, struct snd_pcm **);
+void snd_pcm_set_ops(struct snd_pcm *, int, const struct snd_pcm_ops *);
+void snd_pcm_set_managed_buffer_all(struct snd_pcm *, int, struct device *, size_t, size_t);
+void snd_pcm_set_sync(struct snd_pcm_substream *);
+void snd_pcm_trigger_done(struct snd_pcm_substream *, struct snd_pcm_substream *);
+void snd_pcm_period_elapsed(struct snd_pcm_substream *);
+void snd_pcm_limit_isa_dma_size(int, size_t *);
+size_t snd_pcm_lib_buffer_bytes(struct snd_pcm_substream *);
+size_t snd_pcm_lib_period_bytes(struct snd_pcm_substream *);
+int snd_pcm_format_physical_width(int);
+unsigned int params_rate(struct snd_pcm_hw_params *); unsigned int params_channels(struct snd_pcm_hw_params *);
+int params_format(struct snd_pcm_hw_params *);
+snd_pcm_sframes_t bytes_to_frames(struct snd_pcm_runtime *, ssize_t);
+ssize_t frames_to_bytes(struct snd_pcm_runtime *, snd_pcm_sframes_t);
+void snd_pcm_gettime(struct snd_pcm_runtime *, struct timespec64 *);
+void snd_pcm_stream_lock_irqsave_f(struct snd_pcm_substream *);
+struct snd_ratnum { unsigned int num, den_min, den_max, den_step; };
+struct snd_pcm_hw_constraint_ratnums { int nrats; const struct snd_ratnum *rats; };
+struct snd_pcm_hw_constraint_list { unsigned int count; const unsigned int *list; unsigned int mask; };
+int snd_pcm_hw_constraint_ratnums(struct snd_pcm_runtime *, unsigned int, int, const struct snd_pcm_hw_constraint_ratnums *);
+int snd_pcm_hw_constraint_list(struct snd_pcm_runtime *, unsigned int, int, const struct snd_pcm_hw_constraint_list *);
+#define snd_pcm_substream_chip(s) ((s)->private_data)
+/* What source-4, -5 and -6 still use instead of devm and managed buffers. */
+#define SNDRV_DEV_LOWLEVEL 0x1000
+struct snd_device;
+struct snd_device_ops { int (*dev_free)(struct snd_device *); };
+struct snd_device { void *device_data; const struct snd_device_ops *ops; };
+int snd_device_new(struct snd_card *, int, void *, const struct snd_device_ops *);
+int snd_device_free(struct snd_card *, void *);
+int snd_pcm_lib_ioctl(struct snd_pcm_substream *, unsigned int, void *);
+int snd_pcm_lib_malloc_pages(struct snd_pcm_substream *, size_t);
+int snd_pcm_lib_free_pages(struct snd_pcm_substream *);
+int snd_pcm_lib_preallocate_pages_for_all(struct snd_pcm *, int, void *, size_t, size_t);
+#define snd_dma_isa_data() NULL
+int snd_pcm_suspend_all(struct snd_pcm *);
+unsigned int params_buffer_bytes(struct snd_pcm_hw_params *);
+#define snd_pcm_group_for_each_entry(s, sub) for ((s) = (sub); (s); (s) = NULL)
+/* control */
+#define SNDRV_CTL_ELEM_IFACE_CARD 0
+#define SNDRV_CTL_ELEM_IFACE_MIXER 2
+#define SNDRV_CTL_ELEM_TYPE_BOOLEAN 1
+#define SNDRV_CTL_ELEM_TYPE_INTEGER 2
+#define SNDRV_CTL_ELEM_ACCESS_READWRITE 3
+#define SNDRV_CTL_ELEM_ACCESS_TLV_READ 0x10
+struct snd_ctl_elem_info { int type; unsigned int count; union { struct { long min, max, step; } integer; } value; };
+struct snd_ctl_elem_value { union { union { long value[128]; } integer; union { unsigned int item[128]; } enumerated; } value; };
+struct snd_kcontrol;
+typedef int snd_kcontrol_info_t(struct snd_kcontrol *, struct snd_ctl_elem_info *);
+typedef int snd_kcontrol_get_t(struct snd_kcontrol *, struct snd_ctl_elem_value *);
+typedef int snd_kcontrol_put_t(struct snd_kcontrol *, struct snd_ctl_elem_value *);
+struct snd_kcontrol_new { int iface; const char *name; unsigned int index; unsigned int access;
+	snd_kcontrol_info_t *info; snd_kcontrol_get_t *get; snd_kcontrol_put_t *put;
+	union { const unsigned int *p; } tlv; unsigned long private_value; };
+struct snd_kcontrol { unsigned long private_value; void *private_data; struct snd_kcontrol_new new; };
+#define snd_kcontrol_chip(k) ((k)->private_data)
+struct snd_kcontrol *snd_ctl_new1(const struct snd_kcontrol_new *, void *);
+int snd_ctl_add(struct snd_card *, struct snd_kcontrol *);
+int snd_ctl_enum_info(struct snd_ctl_elem_info *, unsigned int, unsigned int, const char *const *);
+int snd_ctl_boolean_mono_info(struct snd_kcontrol *, struct snd_ctl_elem_info *);
+#define DECLARE_TLV_DB_SCALE(n, min, step, mute) unsigned int n[] = { 1, 8, (min), (step) | ((mute) ? 0x10000 : 0) }
+#define IEC958_AES0_PROFESSIONAL 1
+#define IEC958_AES1_CON_PCM_CODER 2
+#define IEC958_AES0_CON_EMPHASIS_NONE 0
+#define SNDRV_CTL_NAME_IEC958(a,b,c) "IEC958 " a b c
+/* timer */
+#define SNDRV_TIMER_CLASS_CARD 1
+#define SNDRV_TIMER_SCLASS_NONE 0
+#define SNDRV_TIMER_HW_AUTO 1
+struct snd_timer;
+struct snd_timer_hardware { unsigned int flags; unsigned long resolution, ticks;
+	int (*open)(struct snd_timer *); int (*close)(struct snd_timer *);
+	unsigned long (*c_resolution)(struct snd_timer *); int (*start)(struct snd_timer *); int (*stop)(struct snd_timer *); };
+struct snd_timer { struct snd_timer_hardware hw; char name[64]; void *private_data; void (*private_free)(struct snd_timer *);
+	unsigned long sticks; };
+struct snd_timer_id { int dev_class, dev_sclass, card, device, subdevice; };
+#define snd_timer_chip(t) ((t)->private_data)
+int snd_timer_new(struct snd_card *, const char *, struct snd_timer_id *, struct snd_timer **);
+void snd_timer_interrupt(struct snd_timer *, unsigned long);
+/* opl3 / mpu401 */
+#define OPL3_HW_OPL3_CS 0x0302
+#define OPL3_HW_OPL3 0x0300
+struct snd_opl3 { int x; };
+int snd_opl3_create(struct snd_card *, unsigned long, unsigned long, unsigned short, int, struct snd_opl3 **);
+int snd_opl3_hwdep_new(struct snd_opl3 *, int, int, void *);
+#define MPU401_HW_CS4232 18
+#define MPU401_INFO_IRQ_HOOK (1<<4)
+int snd_mpu401_uart_new(struct snd_card *, int, unsigned short, unsigned long, unsigned int, int, void *);
+#endif
@@ -0,0 +1 @@
+#include "astub.h"
@@ -0,0 +1,336 @@
+/*
+ * Copyright (C) 2026  linic@hotmail.ca Subject to GPL-3.0 license.
+ * https://github.com/linic/tcl-core-560z
+ *
+ * The same scenario for every driver tree: source-4, source-5, source-6 and
+ * source-6.18.8. harness.c checks what only 6.18.8 has (wss_regs, pause,
+ * get_time_info, resume of a running stream); this one only calls what the
+ * four trees have in common so iodiff.sh can put their port I/O side by side
+ * and show which port added calibrations or register traffic.
+ *
+ * One line per operation on stdout, tab separated:
+ *	operation in out dma udelay_us sleep_us irqs periods calibrations faults
+ * every port access in the -t trace, like harness -t, and in the -w file only
+ * the codec writes, decoded: "I6 0x3f", "X14 0x10", "R0 0x4c" when MCE or TRD
+ * change, "R2 0x00". Without the times and the 8237, two -w files of two
+ * trees diff into what the drivers wrote differently.
+ *
+ * Faults of the model are a column, not a failure: the older trees write I8
+ * and I9 without MCE in their probe, which the codec drops, and that is
+ * exactly the kind of difference this is for. The exit status is 1 only
+ * when a driver call failed.
+ */
+#include <getopt.h>
+#include <stdlib.h>
+#include <sound/core.h>
+#include <sound/wss.h>
+#include "cs4237b.h"
+#include "emu.h"
+
+static struct snd_wss *chip;
+static struct snd_pcm_substream subs[2];
+static struct snd_pcm_runtime runtimes[2];
+static struct snd_pcm_mmap_status statuses[2];
+static int failed;
+
+static struct {
+	const char *name;
+	struct emu_counters cnt;
+	unsigned int faults, calibrations;
+} op;
+
+static unsigned int all_faults(void)
+{
+	return emu_cnt.faults + cs4237b_fault_count(&codec);
+}
+
+static void op_begin(const char *name)
+{
+	op.name = name;
+	op.cnt = emu_cnt;
+	op.faults = all_faults();
+	op.calibrations = codec.calibrations;
+	emu_trace_mark(name);
+}
+
+static void op_end(void)
+{
+	printf("%s\t%llu\t%llu\t%llu\t%llu\t%llu\t%u\t%u\t%u\t%u\n", op.name,
+	       (unsigned long long)(emu_cnt.codec_in - op.cnt.codec_in),
+	       (unsigned long long)(emu_cnt.codec_out - op.cnt.codec_out),
+	       (unsigned long long)(emu_cnt.dma_io - op.cnt.dma_io),
+	       (unsigned long long)(emu_cnt.udelay_ns - op.cnt.udelay_ns) / 1000,
+	       (unsigned long long)(emu_cnt.sleep_ns - op.cnt.sleep_ns) / 1000,
+	       emu_cnt.irqs - op.cnt.irqs,
+	       emu_cnt.periods[0] + emu_cnt.periods[1] - op.cnt.periods[0] - op.cnt.periods[1],
+	       codec.calibrations - op.calibrations, all_faults() - op.faults);
+}
+
+/*
+ *  What ALSA does around the driver callbacks, as in harness.c
+ */
+
+static const struct snd_pcm_ops *ops(int stream)
+{
+	return emu_pcm->ops[stream];
+}
+
+static int pcm_open(int stream)
+{
+	struct snd_pcm_substream *s = &subs[stream];
+
+	memset(&runtimes[stream], 0, sizeof(runtimes[stream]));
+	memset(&statuses[stream], 0, sizeof(statuses[stream]));
+	s->runtime = &runtimes[stream];
+	s->runtime->status = &statuses[stream];
+	s->pcm = emu_pcm;
+	s->stream = stream;
+	s->private_data = emu_pcm->private_data;
+	return ops(stream)->open(s);
+}
+
+/* 48000 Hz is 16.9344 MHz / 353, 44100 Hz is 16.9344 MHz / 16 / 24: the
+ * ratnums cs4236_lib.c gives ALSA. */
+static int pcm_hw_params(int stream, unsigned int num, unsigned int den)
+{
+	struct snd_pcm_runtime *rt = &runtimes[stream];
+	struct snd_pcm_hw_params p = {
+		.rate_num = num,
+		.rate_den = den,
+		.rate = (num + den / 2) / den,
+		.channels = 2,
+		.format = SNDRV_PCM_FORMAT_S16_LE,
+	};
+
+	rt->rate = p.rate;
+	rt->channels = p.channels;
+	rt->frame_bits = 32;
+	rt->buffer_size = 16384 / 4;
+	rt->period_size = 4096 / 4;
+	rt->dma_addr = stream ? 0x210000 : 0x200000;
+	return ops(stream)->hw_params(&subs[stream], &p);
+}
+
+static int pcm_trigger(int stream, int cmd)
+{
+	unsigned long flags;
+	int err;
+
+	local_irq_save(flags);
+	err = ops(stream)->trigger(&subs[stream], cmd);
+	local_irq_restore(flags);
+	return err;
+}
+
+static void pcm_close(int stream)
+{
+	if (ops(stream)->hw_free)
+		ops(stream)->hw_free(&subs[stream]);
+	ops(stream)->close(&subs[stream]);
+}
+
+static void ctl_put(const char *name, long left, long right)
+{
+	struct snd_kcontrol *kctl = emu_ctl_find(name);
+	struct snd_ctl_elem_value value;
+
+	if (!kctl) {
+		fprintf(stderr, "no \"%s\" control\n", name);
+		failed = 1;
+		return;
+	}
+	memset(&value, 0, sizeof(value));
+	value.value.integer.value[0] = left;
+	value.value.integer.value[1] = right;
+	kctl->new.put(kctl, &value);
+}
+
+/*
+ *  The scenario
+ */
+
+static void run_stream(int stream, unsigned int num, unsigned int den, uint64_t ns)
+{
+	const char *what = stream ? "capture" : "playback";
+	char name[4][32];
+
+	snprintf(name[0], sizeof(name[0]), "%s open+hw_params", what);
+	snprintf(name[1], sizeof(name[1]), "%s prepare+start", what);
+	snprintf(name[2], sizeof(name[2]), "%s %llu ms", what,
+		 (unsigned long long)ns / NSEC_PER_MSEC);
+	snprintf(name[3], sizeof(name[3]), "%s stop+close", what);
+
+	op_begin(name[0]);
+	if (pcm_open(stream) || pcm_hw_params(stream, num, den))
+		failed = 1;
+	op_end();
+	op_begin(name[1]);
+	if (ops(stream)->prepare(&subs[stream]) ||
+	    pcm_trigger(stream, SNDRV_PCM_TRIGGER_START))
+		failed = 1;
+	op_end();
+	op_begin(name[2]);
+	emu_run(ns);
+	op_end();
+	op_begin(name[3]);
+	pcm_trigger(stream, SNDRV_PCM_TRIGGER_STOP);
+	pcm_close(stream);
+	op_end();
+}
+
+static void scenario(void)
+{
+	int i, err;
+
+	op_begin("probe");
+	err = snd_cs4236_create(&emu_card, CS4237B_PORT, CS4237B_IRQ, CS4237B_DMA1,
+				CS4237B_DMA2, WSS_HW_DETECT, 0, &chip);
+	if (!err)
+		err = snd_cs4236_pcm(chip, 0);
+	if (!err)
+		err = snd_cs4236_mixer(chip);
+	op_end();
+	if (err) {
+		fprintf(stderr, "probe returned %d\n", err);
+		failed = 1;
+		return;
+	}
+	op_begin("settle 100 ms");
+	emu_run(100 * NSEC_PER_MSEC);
+	op_end();
+
+	run_stream(0, 16934400, 353, 500 * NSEC_PER_MSEC);
+	run_stream(1, 16934400 / 16, 24, 200 * NSEC_PER_MSEC);
+
+	/* 6.18.8 writes the mixer from a work item, so the time after the
+	 * puts belongs to them. */
+	op_begin("mixer 20 puts+50 ms");
+	for (i = 0; i < 10; i++) {
+		ctl_put("PCM Playback Volume", 40 + i, 40 + i);
+		ctl_put("Master Digital Volume", 20 + i, 20 + i);
+	}
+	emu_run(50 * NSEC_PER_MSEC);
+	op_end();
+
+#ifdef CONFIG_PM
+	/* Idle suspend and a resume after the 560z cut the codec power: the
+	 * older trees can't resume a running stream themselves. */
+	op_begin("suspend");
+	chip->suspend(chip);
+	op_end();
+	cs4237b_dma_reset(&codec);
+	cs4237b_reset(&codec, true, 3 * NSEC_PER_MSEC);
+	op_begin("resume (codec reset)");
+	chip->resume(chip);
+	op_end();
+#endif
+
+	run_stream(0, 16934400, 353, 100 * NSEC_PER_MSEC);
+	op_begin("settle 100 ms");
+	emu_run(100 * NSEC_PER_MSEC);
+	op_end();
+}
+
+/* Reads the trace back and follows R0 and the I23 extended addressing the
+ * same way cs4237b.c does. */
+static int decode_writes(const char *trace, const char *out)
+{
+	unsigned int idx = 0, xreg = 0, r0 = ~0u, port, val;
+	bool mode3 = false, xrae = false;
+	unsigned long long us;
+	char line[128], dir[8];
+	FILE *in, *w;
+
+	in = fopen(trace, "r");
+	w = fopen(out, "w");
+	if (!in || !w) {
+		perror(in ? out : trace);
+		return 2;
+	}
+	while (fgets(line, sizeof(line), in)) {
+		if (line[0] == '#') {
+			fputs(line, w);
+			continue;
+		}
+		if (sscanf(line, "%llu %7s %x %x", &us, dir, &port, &val) != 4 ||
+		    strcmp(dir, "out"))
+			continue;
+		switch (port - CS4237B_PORT) {
+		case 0:
+			xrae = false;
+			idx = val & 0x1f;
+			if ((val & 0x60) != r0)
+				fprintf(w, "R0 0x%02x\n", val);
+			r0 = val & 0x60;
+			break;
+		case 1:
+			if (idx == 23 && mode3 && xrae) {
+				fprintf(w, "X%u 0x%02x\n", xreg, val);
+				break;
+			}
+			if (idx == 12)
+				mode3 = (val & 0x60) == 0x60;
+			if (idx == 23 && mode3 && (val & 0x08)) {
+				xrae = true;
+				xreg = ((val >> 4) & 0x0f) | ((val & 0x04) << 2);
+				break;
+			}
+			fprintf(w, "I%u 0x%02x\n", idx, val);
+			break;
+		case 2:
+		case 3:
+			fprintf(w, "R%u 0x%02x\n", port - CS4237B_PORT, val);
+			break;
+		}
+	}
+	fclose(in);
+	fclose(w);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	const char *trace = NULL, *writes = NULL;
+	int c;
+
+	while ((c = getopt(argc, argv, "t:w:v")) != -1) {
+		switch (c) {
+		case 't':
+			trace = optarg;
+			emu_trace = fopen(trace, "w");
+			if (!emu_trace) {
+				perror(trace);
+				return 2;
+			}
+			break;
+		case 'w':
+			writes = optarg;
+			break;
+		case 'v':
+			emu_verbose = 1;
+			break;
+		default:
+			fprintf(stderr, "usage: iodiff -t trace file [-w writes file] [-v]\n");
+			return 2;
+		}
+	}
+	if (writes && !trace) {
+		fprintf(stderr, "-w needs the -t trace\n");
+		return 2;
+	}
+
+	emu_now = NSEC_PER_SEC;
+	cs4237b_reset(&codec, true, 0);
+	scenario();
+	op_begin("remove");
+	emu_devm_release();
+	op_end();
+
+	if (cs4237b_fault_count(&codec))
+		cs4237b_print_faults(&codec, stderr);
+	if (emu_trace)
+		fclose(emu_trace);
+	if (writes && decode_writes(trace, writes))
+		return 2;
+	return failed;
+}
@@ -0,0 +1,1266 @@
+/*
+ * Copyright (C) 2026  linic@hotmail.ca Subject to GPL-3.0 license.
+ * https://github.com/linic/tcl-core-560z
+ *
+ * The kernel and ALSA functions wss_lib.c and cs4236_lib.c call, on top of
+ * the simulated clock of cs4237b.c. There's one CPU and nothing is
+ * preempted: time only moves when the driver does port I/O (CS4237B_IO_NS
+ * each), delays, sleeps or when the harness lets it idle with emu_run.
+ * The codec interrupt comes in as soon as interrupts are on, so a handler
+ * can run in the middle of a udelay or a sleep like on the 560z.
+ */
+#include <stdarg.h>
+#include <stdlib.h>
+#include "include/sound/astub.h"
+#include "cs4237b.h"
+#include "emu.h"
+
+#define JIFFY_NS	(NSEC_PER_SEC / HZ)
+
+struct emu_counters emu_cnt;
+int emu_verbose;
+FILE *emu_trace;
+volatile unsigned long jiffies;
+
+static struct device emu_device;
+struct snd_card emu_card = { .dev = &emu_device };
+struct snd_pcm *emu_pcm;
+
+/* interrupts */
+static int irq_depth;		/* local_irq_save and friends, the handler itself */
+static uint64_t irqoff_start;
+static int spin_held;
+static bool in_irq;
+static bool irq_pending;	/* edge seen while interrupts were off */
+static irq_handler_t irq_handler, irq_thread;
+static void *irq_dev_id;
+
+void emu_fault(const char *fmt, ...)
+{
+	va_list ap;
+
+	emu_cnt.faults++;
+	fprintf(stderr, "fault at %llu us: ", (unsigned long long)emu_now / 1000);
+	va_start(ap, fmt);
+	vfprintf(stderr, fmt, ap);
+	va_end(ap);
+	fputc('\n', stderr);
+}
+
+void emu_printk(int level, const char *fmt, ...)
+{
+	static const char * const prefix[] = { "err", "warn", "info", "dbg" };
+	va_list ap;
+
+	/* snd_printk(KERN_ERR ...) of the older trees is a dev_err too. */
+	if (fmt[0] == '\001' && fmt[1]) {
+		level = fmt[1] <= '3' ? EMU_LOG_ERR : fmt[1] == '4' ? EMU_LOG_WARN :
+			fmt[1] == '7' ? EMU_LOG_DBG : level;
+		fmt += 2;
+	}
+	if (level == EMU_LOG_ERR)
+		emu_cnt.faults++;
+	if (level > EMU_LOG_WARN && !emu_verbose)
+		return;
+	fprintf(stderr, "%s: ", prefix[level]);
+	va_start(ap, fmt);
+	vfprintf(stderr, fmt, ap);
+	va_end(ap);
+}
+
+void emu_bug(const char *what, const char *file, int line)
+{
+	emu_fault("%s at %s:%d", what, file, line);
+}
+
+/*
+ *  Time and interrupts
+ */
+
+static void sync_jiffies(void)
+{
+	jiffies = emu_now / JIFFY_NS;
+}
+
+static void irqs_off(void)
+{
+	if (!irq_depth++)
+		irqoff_start = emu_now;
+}
+
+static void deliver_irq(void);
+
+static void irqs_on(void)
+{
+	if (irq_depth <= 0) {
+		emu_fault("interrupts enabled twice");
+		return;
+	}
+	if (--irq_depth)
+		return;
+	if (emu_now - irqoff_start > emu_cnt.irqoff_max_ns)
+		emu_cnt.irqoff_max_ns = emu_now - irqoff_start;
+	deliver_irq();
+}
+
+static void deliver_irq(void)
+{
+	irqreturn_t ret;
+
+	while (irq_pending && !irq_depth && !in_irq) {
+		irq_pending = false;
+		if (!irq_handler) {
+			emu_fault("IRQ %d without a handler", CS4237B_IRQ);
+			return;
+		}
+		emu_cnt.irqs++;
+		irqs_off();
+		in_irq = true;
+		ret = irq_handler(CS4237B_IRQ, irq_dev_id);
+		in_irq = false;
+		if (spin_held)
+			emu_fault("IRQ handler returned with a spinlock held");
+		irqs_on();
+		if (ret == IRQ_WAKE_THREAD) {
+			if (irq_thread)
+				irq_thread(CS4237B_IRQ, irq_dev_id);
+			else
+				emu_fault("IRQ_WAKE_THREAD without a thread");
+		}
+	}
+}
+
+/* Move the codec and the clock to until. A rising edge of the IRQ line is
+ * given to the handler right away when interrupts are on. */
+static void emu_advance(uint64_t until)
+{
+	while (cs4237b_run(&codec, until)) {
+		codec.edge = false;
+		irq_pending = true;
+		sync_jiffies();
+		deliver_irq();
+	}
+	sync_jiffies();
+}
+
+bool emu_idle_context(void)
+{
+	return !irq_depth && !spin_held && !in_irq;
+}
+
+void might_sleep(void)
+{
+	if (irq_depth || spin_held || in_irq)
+		emu_fault("sleeping with %s", in_irq ? "the IRQ handler running" :
+			  spin_held ? "a spinlock held" : "interrupts off");
+}
+
+u64 local_clock(void)
+{
+	return emu_now;
+}
+
+ktime_t ktime_get(void)
+{
+	return emu_now;
+}
+
+ktime_t ktime_get_raw(void)
+{
+	return emu_now;
+}
+
+ktime_t ktime_get_boottime(void)
+{
+	return emu_now;
+}
+
+u64 ktime_get_ns(void)
+{
+	return emu_now;
+}
+
+struct timespec64 ns_to_timespec64(s64 ns)
+{
+	struct timespec64 ts = { ns / NSEC_PER_SEC, ns % NSEC_PER_SEC };
+
+	return ts;
+}
+
+unsigned long msecs_to_jiffies(unsigned int ms)
+{
+	return DIV_ROUND_UP((unsigned long)ms * HZ, 1000);
+}
+
+unsigned long usecs_to_jiffies(unsigned int us)
+{
+	return DIV_ROUND_UP((unsigned long)us * HZ, 1000000);
+}
+
+unsigned int jiffies_to_msecs(unsigned long j)
+{
+	return j * 1000 / HZ;
+}
+
+unsigned int jiffies_to_usecs(unsigned long j)
+{
+	return j * 1000000 / HZ;
+}
+
+void ndelay(unsigned long ns)
+{
+	emu_cnt.udelay_ns += ns;
+	emu_advance(emu_now + ns);
+}
+
+void udelay(unsigned long us)
+{
+	ndelay(us * NSEC_PER_USEC);
+}
+
+void mdelay(unsigned long ms)
+{
+	ndelay(ms * NSEC_PER_MSEC);
+}
+
+static void sleep_until(uint64_t t)
+{
+	might_sleep();
+	if (t <= emu_now)
+		return;
+	emu_cnt.sleep_ns += t - emu_now;
+	emu_advance(t);
+}
+
+/* A timer sleep ends on a tick: the one after the timeout, like
+ * schedule_timeout adds one jiffy to be sure it's long enough. */
+void msleep(unsigned int ms)
+{
+	sleep_until((jiffies + msecs_to_jiffies(ms) + 1) * JIFFY_NS);
+}
+
+/* hrtimer with slack; max is taken, which is what an idle 560z gives. */
+void usleep_range(unsigned long min_us, unsigned long max_us)
+{
+	sleep_until(emu_now + max_us * NSEC_PER_USEC);
+}
+
+void fsleep(unsigned long us)
+{
+	if (us < 10)
+		udelay(us);
+	else if (us <= 20000)
+		usleep_range(us, 2 * us);
+	else
+		msleep(DIV_ROUND_UP(us, 1000));
+}
+
+int schedule_timeout_uninterruptible(long timeout)
+{
+	sleep_until((jiffies + timeout) * JIFFY_NS);
+	return 0;
+}
+
+int schedule_timeout_interruptible(long timeout)
+{
+	return schedule_timeout_uninterruptible(timeout);
+}
+
+void cpu_relax(void)
+{
+}
+
+void mb(void)
+{
+}
+
+void rmb(void)
+{
+}
+
+void wmb(void)
+{
+}
+
+void barrier(void)
+{
+}
+
+void smp_mb(void)
+{
+}
+
+/*
+ *  Port I/O
+ */
+
+static bool dma_port(unsigned long port)
+{
+	return port <= 0x0f || (port >= 0x80 && port <= 0x8f);
+}
+
+static void port_account(unsigned long port, uint8_t val, bool out, bool handled)
+{
+	if (!handled) {
+		/* Counted with the codec faults. */
+		codec.f.bad_ports++;
+		fprintf(stderr, "fault at %llu us: %s of port 0x%lx\n",
+			(unsigned long long)emu_now / 1000, out ? "write" : "read", port);
+	}
+	if (dma_port(port))
+		emu_cnt.dma_io++;
+	else if (out)
+		emu_cnt.codec_out++;
+	else
+		emu_cnt.codec_in++;
+	if (emu_trace)
+		fprintf(emu_trace, "%llu\t%s\t0x%03lx\t0x%02x\n",
+			(unsigned long long)emu_now / 1000, out ? "out" : "in", port, val);
+}
+
+unsigned char inb(unsigned long port)
+{
+	bool handled;
+	uint8_t val;
+
+	emu_advance(emu_now + CS4237B_IO_NS);
+	val = cs4237b_port_in(&codec, port, &handled);
+	port_account(port, val, false, handled);
+	return val;
+}
+
+void outb(unsigned char val, unsigned long port)
+{
+	bool handled;
+
+	emu_advance(emu_now + CS4237B_IO_NS);
+	cs4237b_port_out(&codec, val, port, &handled);
+	port_account(port, val, true, handled);
+	/* A write can raise the line (IEN set with a bit pending). */
+	if (codec.edge)
+		emu_advance(emu_now);
+}
+
+void emu_trace_mark(const char *name)
+{
+	if (emu_trace)
+		fprintf(emu_trace, "# %s\n", name);
+}
+
+/*
+ *  Locks. One CPU: a lock only records that it's held.
+ */
+
+void spin_lock_init(spinlock_t *l)
+{
+	l->locked = 0;
+}
+
+void spin_lock(spinlock_t *l)
+{
+	if (l->locked)
+		emu_fault("spinlock taken twice, this deadlocks");
+	l->locked = 1;
+	spin_held++;
+}
+
+void spin_unlock(spinlock_t *l)
+{
+	if (!l->locked)
+		emu_fault("spinlock released twice");
+	l->locked = 0;
+	spin_held--;
+}
+
+void spin_lock_irq(spinlock_t *l)
+{
+	irqs_off();
+	spin_lock(l);
+}
+
+void spin_unlock_irq(spinlock_t *l)
+{
+	spin_unlock(l);
+	irqs_on();
+}
+
+unsigned long emu_spin_lock_irqsave(spinlock_t *l)
+{
+	irqs_off();
+	spin_lock(l);
+	return 0;
+}
+
+void spin_unlock_irqrestore(spinlock_t *l, unsigned long flags)
+{
+	spin_unlock(l);
+	irqs_on();
+}
+
+unsigned long emu_local_irq_save(void)
+{
+	irqs_off();
+	return 0;
+}
+
+void local_irq_restore(unsigned long flags)
+{
+	irqs_on();
+}
+
+void mutex_init(struct mutex *m)
+{
+	m->locked = 0;
+}
+
+void mutex_lock(struct mutex *m)
+{
+	might_sleep();
+	if (m->locked)
+		emu_fault("mutex taken twice, this deadlocks");
+	m->locked = 1;
+}
+
+void mutex_unlock(struct mutex *m)
+{
+	if (!m->locked)
+		emu_fault("mutex released twice");
+	m->locked = 0;
+}
+
+int mutex_trylock(struct mutex *m)
+{
+	if (m->locked)
+		return 0;
+	m->locked = 1;
+	return 1;
+}
+
+int mutex_is_locked(struct mutex *m)
+{
+	return m->locked;
+}
+
+struct __guard_spinlock __guard_spinlock_init(spinlock_t *l)
+{
+	spin_lock(l);
+	return (struct __guard_spinlock){ l, 0 };
+}
+
+void __guard_spinlock_exit(struct __guard_spinlock *g)
+{
+	spin_unlock(g->l);
+}
+
+struct __guard_spinlock_irq __guard_spinlock_irq_init(spinlock_t *l)
+{
+	spin_lock_irq(l);
+	return (struct __guard_spinlock_irq){ l, 0 };
+}
+
+void __guard_spinlock_irq_exit(struct __guard_spinlock_irq *g)
+{
+	spin_unlock_irq(g->l);
+}
+
+struct __guard_spinlock_irqsave __guard_spinlock_irqsave_init(spinlock_t *l)
+{
+	return (struct __guard_spinlock_irqsave){ l, 0, emu_spin_lock_irqsave(l) };
+}
+
+void __guard_spinlock_irqsave_exit(struct __guard_spinlock_irqsave *g)
+{
+	spin_unlock_irqrestore(g->l, g->flags);
+}
+
+struct __guard_mutex __guard_mutex_init(struct mutex *m)
+{
+	mutex_lock(m);
+	return (struct __guard_mutex){ m, 0 };
+}
+
+void __guard_mutex_exit(struct __guard_mutex *g)
+{
+	mutex_unlock(g->l);
+}
+
+/*
+ *  Work and completions. Plain work runs when something waits for it or when
+ *  the harness idles; delayed work only when the harness idles past its due
+ *  jiffy. Running pending_work from inside a wait would take mce_mutex the
+ *  waiter may hold, which the real kernel would simply let wait.
+ */
+
+static struct work_struct *work_list;
+
+static void work_queue(struct work_struct *w, unsigned long due)
+{
+	struct work_struct **p;
+
+	w->pending = 1;
+	w->due = due;
+	w->next = NULL;
+	for (p = &work_list; *p; p = &(*p)->next)
+		;
+	*p = w;
+}
+
+static bool work_dequeue(struct work_struct *w)
+{
+	struct work_struct **p;
+
+	for (p = &work_list; *p; p = &(*p)->next)
+		if (*p == w) {
+			*p = w->next;
+			w->pending = 0;
+			w->next = NULL;
+			return true;
+		}
+	return false;
+}
+
+static void work_run(struct work_struct *w)
+{
+	if (!emu_idle_context())
+		emu_fault("work run with a lock held or interrupts off");
+	work_dequeue(w);
+	w->func(w);
+}
+
+/* Run the first plain work queued. False when there's none. */
+static bool work_run_plain(void)
+{
+	struct work_struct *w;
+
+	for (w = work_list; w; w = w->next)
+		if (!w->delayed) {
+			work_run(w);
+			return true;
+		}
+	return false;
+}
+
+bool schedule_work(struct work_struct *w)
+{
+	if (w->pending)
+		return false;
+	work_queue(w, jiffies);
+	return true;
+}
+
+bool schedule_delayed_work(struct delayed_work *dw, unsigned long delay)
+{
+	if (dw->work.pending)
+		return false;
+	work_queue(&dw->work, jiffies + delay);
+	return true;
+}
+
+bool emu_mod_delayed_work(struct delayed_work *dw, unsigned long delay)
+{
+	if (dw->work.pending) {
+		dw->work.due = jiffies + delay;
+		return true;
+	}
+	work_queue(&dw->work, jiffies + delay);
+	return false;
+}
+
+bool cancel_work_sync(struct work_struct *w)
+{
+	return work_dequeue(w);
+}
+
+bool cancel_delayed_work_sync(struct delayed_work *dw)
+{
+	return work_dequeue(&dw->work);
+}
+
+bool cancel_delayed_work(struct delayed_work *dw)
+{
+	return work_dequeue(&dw->work);
+}
+
+bool flush_work(struct work_struct *w)
+{
+	might_sleep();
+	if (!w->pending)
+		return false;
+	work_run(w);
+	return true;
+}
+
+bool flush_delayed_work(struct delayed_work *dw)
+{
+	return flush_work(&dw->work);
+}
+
+bool work_pending(struct work_struct *w)
+{
+	return w->pending;
+}
+
+bool delayed_work_pending(struct delayed_work *dw)
+{
+	return dw->work.pending;
+}
+
+#define COMPLETION_ALL	0x7fffffff
+
+void init_completion(struct completion *c)
+{
+	c->done = 0;
+}
+
+void reinit_completion(struct completion *c)
+{
+	c->done = 0;
+}
+
+void complete(struct completion *c)
+{
+	if (c->done != COMPLETION_ALL)
+		c->done++;
+}
+
+void complete_all(struct completion *c)
+{
+	c->done = COMPLETION_ALL;
+}
+
+bool completion_done(struct completion *c)
+{
+	return c->done;
+}
+
+void wait_for_completion(struct completion *c)
+{
+	might_sleep();
+	while (!c->done)
+		if (!work_run_plain()) {
+			emu_fault("wait_for_completion would wait forever");
+			return;
+		}
+	if (c->done != COMPLETION_ALL)
+		c->done--;
+}
+
+unsigned long wait_for_completion_timeout(struct completion *c, unsigned long timeout)
+{
+	wait_for_completion(c);
+	return c->done ? 1 : 0;
+}
+
+void emu_run(uint64_t ns)
+{
+	uint64_t until = emu_now + ns;
+	struct work_struct *w, *first;
+
+	if (!emu_idle_context())
+		emu_fault("idle with a lock held or interrupts off");
+	for (;;) {
+		if (work_run_plain())
+			continue;
+		first = NULL;
+		for (w = work_list; w; w = w->next)
+			if (!first || time_before(w->due, first->due))
+				first = w;
+		if (!first || first->due * JIFFY_NS > until)
+			break;
+		if (first->due * JIFFY_NS > emu_now)
+			emu_advance(first->due * JIFFY_NS);
+		work_run(first);
+	}
+	if (until > emu_now)
+		emu_advance(until);
+}
+
+/*
+ *  Module parameters
+ */
+
+#define EMU_PARAMS	16
+
+static struct {
+	const char *name;
+	void *var;
+	size_t size;
+} params[EMU_PARAMS];
+static int nparams;
+
+void emu_param_register(const char *name, void *var, size_t size)
+{
+	if (nparams < EMU_PARAMS)
+		params[nparams++] = (typeof(params[0])){ name, var, size };
+}
+
+int emu_param_set(const char *name, const char *val)
+{
+	long v = strtol(val, NULL, 0);
+	int i;
+
+	if (!strcmp(val, "Y") || !strcmp(val, "y"))
+		v = 1;
+	for (i = 0; i < nparams; i++) {
+		if (strcmp(params[i].name, name))
+			continue;
+		if (params[i].size == sizeof(bool))
+			*(bool *)params[i].var = v;
+		else
+			*(int *)params[i].var = v;
+		return 0;
+	}
+	return -ENOENT;
+}
+
+/*
+ *  Devices and resources
+ */
+
+#define EMU_ACTIONS	8
+
+static struct {
+	void (*fn)(void *);
+	void *data;
+} actions[EMU_ACTIONS];
+static int nactions;
+
+void *devm_kzalloc(struct device *dev, size_t size, gfp_t gfp)
+{
+	return calloc(1, size);
+}
+
+void *kzalloc(size_t size, gfp_t gfp)
+{
+	return calloc(1, size);
+}
+
+void kfree(const void *p)
+{
+	free((void *)p);
+}
+
+struct resource *devm_request_region(struct device *dev, unsigned long start,
+				     unsigned long n, const char *name)
+{
+	static struct resource res;
+
+	if (start != CS4237B_PORT)
+		return NULL;
+	res.start = start;
+	res.end = start + n - 1;
+	return &res;
+}
+
+int devm_request_irq(struct device *dev, unsigned int irq, irq_handler_t handler,
+		     unsigned long flags, const char *name, void *dev_id)
+{
+	return devm_request_threaded_irq(dev, irq, handler, NULL, flags, name, dev_id);
+}
+
+int devm_request_threaded_irq(struct device *dev, unsigned int irq, irq_handler_t handler,
+			      irq_handler_t thread, unsigned long flags, const char *name,
+			      void *dev_id)
+{
+	if (irq != CS4237B_IRQ)
+		return -EBUSY;
+	irq_handler = handler;
+	irq_thread = thread;
+	irq_dev_id = dev_id;
+	return 0;
+}
+
+int devm_add_action_or_reset(struct device *dev, void (*fn)(void *), void *data)
+{
+	if (nactions == EMU_ACTIONS) {
+		fn(data);
+		return -ENOMEM;
+	}
+	actions[nactions].fn = fn;
+	actions[nactions++].data = data;
+	return 0;
+}
+
+void emu_devm_release(void)
+{
+	while (nactions) {
+		nactions--;
+		actions[nactions].fn(actions[nactions].data);
+	}
+	irq_handler = NULL;
+	irq_thread = NULL;
+}
+
+int snd_devm_request_dma(struct device *dev, int dma, const char *name)
+{
+	return dma == CS4237B_DMA1 || dma == CS4237B_DMA2 ? 0 : -EBUSY;
+}
+
+/* source-4, -5 and -6 take the resources without devm and free the chip
+ * through a snd_device, which goes with the card like the devm actions. */
+static struct snd_device lowlevel;
+
+static void lowlevel_free(void *data)
+{
+	struct snd_device *device = data;
+
+	device->ops->dev_free(device);
+}
+
+int snd_device_new(struct snd_card *card, int type, void *device_data,
+		   const struct snd_device_ops *ops)
+{
+	lowlevel.device_data = device_data;
+	lowlevel.ops = ops;
+	return devm_add_action_or_reset(card->dev, lowlevel_free, &lowlevel);
+}
+
+int snd_device_free(struct snd_card *card, void *device_data)
+{
+	return 0;
+}
+
+struct resource *request_region(unsigned long start, unsigned long n, const char *name)
+{
+	return devm_request_region(NULL, start, n, name);
+}
+
+void release_and_free_resource(struct resource *res)
+{
+}
+
+int request_irq(unsigned int irq, irq_handler_t handler, unsigned long flags,
+		const char *name, void *dev_id)
+{
+	return devm_request_irq(NULL, irq, handler, flags, name, dev_id);
+}
+
+/* Nothing runs the handler behind the caller's back here. */
+void disable_irq(unsigned int irq)
+{
+}
+
+void free_irq(unsigned int irq, void *dev_id)
+{
+	irq_handler = NULL;
+	irq_thread = NULL;
+}
+
+int request_dma(unsigned int dma, const char *name)
+{
+	return snd_devm_request_dma(NULL, dma, name);
+}
+
+void free_dma(unsigned int dma)
+{
+}
+
+/*
+ *  8237, asm/dma.h and sound/core/isadma.c
+ */
+
+static const uint8_t dma_page_port[4] = { 0x87, 0x83, 0x81, 0x82 };
+
+unsigned long claim_dma_lock(void)
+{
+	return emu_local_irq_save();
+}
+
+void release_dma_lock(unsigned long flags)
+{
+	local_irq_restore(flags);
+}
+
+void enable_dma(unsigned int ch)
+{
+	outb(ch, 0x0a);
+}
+
+void disable_dma(unsigned int ch)
+{
+	outb(ch | 4, 0x0a);
+}
+
+void clear_dma_ff(unsigned int ch)
+{
+	outb(0, 0x0c);
+}
+
+void set_dma_mode(unsigned int ch, char mode)
+{
+	outb((unsigned char)mode | ch, 0x0b);
+}
+
+void set_dma_addr(unsigned int ch, unsigned int addr)
+{
+	outb(addr >> 16, dma_page_port[ch]);
+	outb(addr & 0xff, ch << 1);
+	outb((addr >> 8) & 0xff, ch << 1);
+}
+
+void set_dma_count(unsigned int ch, unsigned int count)
+{
+	count--;
+	outb(count & 0xff, (ch << 1) + 1);
+	outb((count >> 8) & 0xff, (ch << 1) + 1);
+}
+
+int get_dma_residue(unsigned int ch)
+{
+	int count = 1 + inb((ch << 1) + 1);
+
+	count += inb((ch << 1) + 1) << 8;
+	return count;
+}
+
+void snd_dma_program(unsigned long dma, unsigned long addr, unsigned int size,
+		     unsigned short mode)
+{
+	unsigned long flags = claim_dma_lock();
+
+	disable_dma(dma);
+	clear_dma_ff(dma);
+	set_dma_mode(dma, mode);
+	set_dma_addr(dma, addr);
+	set_dma_count(dma, size);
+	if (!(mode & DMA_MODE_NO_ENABLE))
+		enable_dma(dma);
+	release_dma_lock(flags);
+}
+
+void snd_dma_disable(unsigned long dma)
+{
+	unsigned long flags = claim_dma_lock();
+
+	clear_dma_ff(dma);
+	disable_dma(dma);
+	release_dma_lock(flags);
+}
+
+unsigned int snd_dma_pointer(unsigned long dma, unsigned int size)
+{
+	unsigned long flags = claim_dma_lock();
+	unsigned int result, result1;
+
+	clear_dma_ff(dma);
+	disable_dma(dma);
+	result = get_dma_residue(dma);
+	/* The count can change between the low and the high byte, read twice. */
+	result1 = get_dma_residue(dma);
+	enable_dma(dma);
+	release_dma_lock(flags);
+	if (result < result1)
+		result = result1;
+	if (result >= size || result == 0)
+		return 0;
+	return size - result;
+}
+
+/*
+ *  PCM
+ */
+
+int snd_pcm_new(struct snd_card *card, const char *id, int device, int playback,
+		int capture, struct snd_pcm **rpcm)
+{
+	struct snd_pcm *pcm = calloc(1, sizeof(*pcm));
+
+	if (!pcm)
+		return -ENOMEM;
+	pcm->card = card;
+	emu_pcm = pcm;
+	*rpcm = pcm;
+	return 0;
+}
+
+void snd_pcm_set_ops(struct snd_pcm *pcm, int stream, const struct snd_pcm_ops *ops)
+{
+	pcm->ops[stream] = ops;
+}
+
+void snd_pcm_set_managed_buffer_all(struct snd_pcm *pcm, int type, struct device *dev,
+				    size_t size, size_t max)
+{
+}
+
+void snd_pcm_set_sync(struct snd_pcm_substream *substream)
+{
+}
+
+void snd_pcm_trigger_done(struct snd_pcm_substream *substream,
+			  struct snd_pcm_substream *master)
+{
+}
+
+void snd_pcm_limit_isa_dma_size(int dma, size_t *max)
+{
+	size_t limit = dma > 3 ? 128 * 1024 : 64 * 1024;
+
+	if (*max > limit)
+		*max = limit;
+}
+
+ssize_t frames_to_bytes(struct snd_pcm_runtime *runtime, snd_pcm_sframes_t frames)
+{
+	return frames * runtime->frame_bits / 8;
+}
+
+snd_pcm_sframes_t bytes_to_frames(struct snd_pcm_runtime *runtime, ssize_t bytes)
+{
+	return bytes * 8 / runtime->frame_bits;
+}
+
+size_t snd_pcm_lib_buffer_bytes(struct snd_pcm_substream *substream)
+{
+	return frames_to_bytes(substream->runtime, substream->runtime->buffer_size);
+}
+
+size_t snd_pcm_lib_period_bytes(struct snd_pcm_substream *substream)
+{
+	return frames_to_bytes(substream->runtime, substream->runtime->period_size);
+}
+
+unsigned int params_rate(struct snd_pcm_hw_params *p)
+{
+	return p->rate;
+}
+
+unsigned int params_channels(struct snd_pcm_hw_params *p)
+{
+	return p->channels;
+}
+
+int params_format(struct snd_pcm_hw_params *p)
+{
+	return p->format;
+}
+
+void snd_pcm_gettime(struct snd_pcm_runtime *runtime, struct timespec64 *tv)
+{
+	*tv = ns_to_timespec64(emu_now);
+}
+
+int snd_pcm_hw_constraint_ratnums(struct snd_pcm_runtime *runtime, unsigned int cond,
+				  int var, const struct snd_pcm_hw_constraint_ratnums *r)
+{
+	return 0;
+}
+
+int snd_pcm_hw_constraint_list(struct snd_pcm_runtime *runtime, unsigned int cond,
+			       int var, const struct snd_pcm_hw_constraint_list *l)
+{
+	return 0;
+}
+
+/* The buffer is already set up by the harness when hw_params runs. */
+int snd_pcm_lib_ioctl(struct snd_pcm_substream *substream, unsigned int cmd, void *arg)
+{
+	return 0;
+}
+
+int snd_pcm_lib_malloc_pages(struct snd_pcm_substream *substream, size_t size)
+{
+	return 0;
+}
+
+int snd_pcm_lib_free_pages(struct snd_pcm_substream *substream)
+{
+	return 0;
+}
+
+int snd_pcm_lib_preallocate_pages_for_all(struct snd_pcm *pcm, int type, void *data,
+					  size_t size, size_t max)
+{
+	return 0;
+}
+
+unsigned int params_buffer_bytes(struct snd_pcm_hw_params *p)
+{
+	return 0;
+}
+
+/* The harness sends SNDRV_PCM_TRIGGER_SUSPEND itself. */
+int snd_pcm_suspend_all(struct snd_pcm *pcm)
+{
+	return 0;
+}
+
+/* What snd_pcm_update_hw_ptr does with the pointer, without the xrun and
+ * jiffies checks: a smaller position than last time is a wrap. */
+void snd_pcm_period_elapsed(struct snd_pcm_substream *substream)
+{
+	struct snd_pcm_runtime *runtime = substream->runtime;
+	snd_pcm_uframes_t pos;
+	unsigned long flags;
+
+	emu_cnt.periods[substream->stream]++;
+	local_irq_save(flags);
+	pos = substream->pcm->ops[substream->stream]->pointer(substream);
+	if (pos >= runtime->buffer_size) {
+		emu_fault("pointer %lu beyond the buffer", pos);
+		pos = 0;
+	}
+	if (runtime->hw_ptr_base + pos < runtime->status->hw_ptr)
+		runtime->hw_ptr_base += runtime->buffer_size;
+	runtime->status->hw_ptr = runtime->hw_ptr_base + pos;
+	local_irq_restore(flags);
+}
+
+/* Only snd_wss_timer of the older trees, which nothing here calls. */
+int snd_timer_new(struct snd_card *card, const char *id, struct snd_timer_id *tid,
+		  struct snd_timer **rtimer)
+{
+	return -ENODEV;
+}
+
+void snd_timer_interrupt(struct snd_timer *timer, unsigned long ticks)
+{
+}
+
+/*
+ *  Controls
+ */
+
+#define EMU_CONTROLS	64
+
+static struct snd_kcontrol *controls[EMU_CONTROLS];
+static int ncontrols;
+
+struct snd_kcontrol *snd_ctl_new1(const struct snd_kcontrol_new *ncontrol, void *private_data)
+{
+	struct snd_kcontrol *kctl = calloc(1, sizeof(*kctl));
+
+	if (!kctl)
+		return NULL;
+	kctl->new = *ncontrol;
+	kctl->private_value = ncontrol->private_value;
+	kctl->private_data = private_data;
+	return kctl;
+}
+
+int snd_ctl_add(struct snd_card *card, struct snd_kcontrol *kctl)
+{
+	if (!kctl)
+		return -EINVAL;
+	if (ncontrols == EMU_CONTROLS)
+		return -ENOMEM;
+	controls[ncontrols++] = kctl;
+	return 0;
+}
+
+struct snd_kcontrol *emu_ctl_find(const char *name)
+{
+	int i;
+
+	for (i = 0; i < ncontrols; i++)
+		if (!strcmp(controls[i]->new.name, name))
+			return controls[i];
+	return NULL;
+}
+
+int snd_ctl_enum_info(struct snd_ctl_elem_info *info, unsigned int channels,
+		      unsigned int items, const char *const names[])
+{
+	info->count = channels;
+	return 0;
+}
+
+int snd_ctl_boolean_mono_info(struct snd_kcontrol *kctl, struct snd_ctl_elem_info *info)
+{
+	info->type = SNDRV_CTL_ELEM_TYPE_BOOLEAN;
+	info->count = 1;
+	info->value.integer.min = 0;
+	info->value.integer.max = 1;
+	return 0;
+}
+
+/*
+ *  /proc/asound/cardX
+ */
+
+struct snd_info_buffer {
+	char *buf;
+	size_t len, size, pos;
+};
+
+#define EMU_PROCS	8
+
+static struct snd_info_entry procs[EMU_PROCS];
+static int nprocs;
+
+int snd_card_rw_proc_new(struct snd_card *card, const char *name, void *private_data,
+			 snd_info_read_t read, snd_info_write_t write)
+{
+	if (nprocs == EMU_PROCS)
+		return -ENOMEM;
+	procs[nprocs++] = (struct snd_info_entry){ private_data, name, read, write };
+	return 0;
+}
+
+int snd_card_ro_proc_new(struct snd_card *card, const char *name, void *private_data,
+			 snd_info_read_t read)
+{
+	return snd_card_rw_proc_new(card, name, private_data, read, NULL);
+}
+
+struct snd_info_entry *emu_proc_find(const char *name)
+{
+	int i;
+
+	for (i = 0; i < nprocs; i++)
+		if (!strcmp(procs[i].name, name))
+			return &procs[i];
+	return NULL;
+}
+
+void snd_iprintf(struct snd_info_buffer *buffer, const char *fmt, ...)
+{
+	va_list ap;
+	int n;
+
+	if (buffer->len >= buffer->size)
+		return;
+	va_start(ap, fmt);
+	n = vsnprintf(buffer->buf + buffer->len, buffer->size - buffer->len, fmt, ap);
+	va_end(ap);
+	buffer->len = min(buffer->len + n, buffer->size);
+}
+
+int snd_info_get_line(struct snd_info_buffer *buffer, char *line, int len)
+{
+	int c = 0;
+
+	if (buffer->pos >= buffer->len)
+		return 1;
+	while (buffer->pos < buffer->len && buffer->buf[buffer->pos] != '\n') {
+		if (c < len - 1)
+			line[c++] = buffer->buf[buffer->pos];
+		buffer->pos++;
+	}
+	buffer->pos++;
+	line[c] = '\0';
+	return 0;
+}
+
+int emu_proc_read(const char *name, char *buf, size_t size)
+{
+	struct snd_info_entry *entry = emu_proc_find(name);
+	struct snd_info_buffer buffer = { buf, 0, size - 1, 0 };
+
+	if (!entry || !entry->read)
+		return -ENOENT;
+	entry->read(entry, &buffer);
+	buf[buffer.len] = '\0';
+	return buffer.len;
+}
+
+int emu_proc_write(const char *name, const char *text)
+{
+	struct snd_info_entry *entry = emu_proc_find(name);
+	struct snd_info_buffer buffer = { (char *)text, strlen(text), strlen(text), 0 };
+
+	if (!entry || !entry->write)
+		return -ENOENT;
+	entry->write(entry, &buffer);
+	return 0;
+}
@@ -0,0 +1,25 @@
+#!/bin/sh
+# Copyright (C) 2026  linic@hotmail.ca Subject to GPL-3.0 license.
+# https://github.com/linic/tcl-core-560z
+#
+# Builds the harness with wss_lib.c and cs4236_lib.c of a driver tree and runs
+# it once with the default parameters and once with the IRQ thread and the
+# interpolated pointer. Any argument is passed to both runs, e.g. ./run.sh -S
+# SOURCE picks the tree (default ../source-6.18.8). EMU_CFLAGS replaces the
+# config of the 560z .config if a build without CONFIG_SND_WSS_CS4237B_ONLY
+# has to be checked. Warnings are errors, see cflags.sh.
+set -e
+cd "$(dirname "$0")"
+. ./cflags.sh
+SOURCE=${SOURCE:-../source-6.18.8}
+OUT=${OUT:-/tmp/cs4237b-emulator}
+mkdir -p "$OUT"
+CFLAGS=$(emu_cflags "$SOURCE")
+for f in "$SOURCE/sound/isa/wss/wss_lib.c" "$SOURCE/sound/isa/cs423x/cs4236_lib.c" \
+	 kernel.c harness.c; do
+	gcc $CFLAGS -c "$f" -o "$OUT/$(basename "$f" .c).o"
+done
+gcc -std=gnu11 -O1 -g $EMU_WARN -c cs4237b.c -o "$OUT/cs4237b.o"
+gcc -o "$OUT/harness" "$OUT"/*.o
+"$OUT/harness" "$@"
+"$OUT/harness" -p threaded_irq=1 -p interpolate_pointer=1 "$@"
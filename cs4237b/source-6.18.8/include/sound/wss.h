@@ -7,6 +7,8 @@
  *  Definitions for CS4231 & InterWave chips & compatible chips
  */
 
+#include <linux/completion.h>
+#include <linux/workqueue.h>
 #include <sound/control.h>
 #include <sound/pcm.h>
 #include <sound/timer.h>
@@ -50,6 +52,15 @@
 #define WSS_HW_OPL3SA2       0x1101	/* OPL3-SA2 chip, similar to cs4231 */
 #define WSS_HW_OPTI93X 	0x1102	/* Opti 930/931/933 */
 
+/* snd_wss_probe only accepts the CS4237B of the 560z. With
+ * CONFIG_SND_WSS_CS4237B_ONLY the hardware checks use this constant and the
+ * compiler drops the branches for the other chips. */
+#ifdef CONFIG_SND_WSS_CS4237B_ONLY
+#define snd_wss_hardware(chip)	WSS_HW_CS4237B
+#else
+#define snd_wss_hardware(chip)	((chip)->hardware)
+#endif
+
 /* defines for codec.hwshare */
 #define WSS_HWSHARE_IRQ	(1<<0)
 #define WSS_HWSHARE_DMA1	(1<<1)
@@ -65,6 +76,62 @@
 // super set which is compatible with the CS4232.
 #define WSS_IA01234_MASK 0x1f /* 0001 1111 mask on IA0 to IA4 in WSSbase+0, R0 */
 
+/* places where the time spent with interrupts off is measured */
+enum {
+	WSS_IRQOFF_OUT,			/* snd_wss_out */
+	WSS_IRQOFF_OUT_BATCH,		/* snd_wss_out_batch */
+	WSS_IRQOFF_IN,			/* snd_wss_in */
+	WSS_IRQOFF_EXT_OUT,		/* snd_cs4236_ext_out */
+	WSS_IRQOFF_EXT_OUT_BATCH,	/* snd_cs4236_ext_out_batch */
+	WSS_IRQOFF_EXT_IN,		/* snd_cs4236_ext_in */
+	WSS_IRQOFF_MCE,			/* snd_wss_mce_up/down locked part */
+	WSS_IRQOFF_INTERRUPT,		/* snd_wss_interrupt */
+	WSS_IRQOFF_TRIGGER,		/* snd_wss_trigger */
+	WSS_IRQOFF_SITES
+};
+
+/* snd_wss_busy_wait buckets: 0, up to 1 ms, 10 ms, 100 ms, more */
+#define WSS_BUSY_WAIT_BUCKETS	5
+
+/* calls, total and longest time of a code path, in us */
+struct snd_wss_stat_time {
+	unsigned int count;
+	unsigned int max_us;
+	unsigned long long total_us;
+};
+
+/* counters shown in /proc/asound/cardX/wss_stats */
+struct snd_wss_stats {
+	unsigned int reg_writes;	/* I registers written, batches count each register */
+	unsigned int reg_reads;		/* I registers read */
+	unsigned int ereg_writes;	/* same for the X registers */
+	unsigned int ereg_reads;
+	unsigned int irqoff_max_ns[WSS_IRQOFF_SITES];
+	unsigned int deferred_writes;	/* writes left in the image because INIT was set */
+	unsigned int deferred_flushes;	/* times the deferred writes were written out */
+	unsigned int busy_wait_hist[WSS_BUSY_WAIT_BUCKETS];	/* snd_wss_busy_wait calls by time waited */
+	unsigned int busy_wait_timeouts;	/* INIT still set after 250 ms */
+	unsigned int busy_wait_max_us;
+	unsigned long long busy_wait_total_us;
+	unsigned int mixer_writes;	/* register values put by the mixer controls */
+	unsigned int mixer_flushed;	/* of those, registers actually written */
+	unsigned int pointer_calls;	/* PCM pointer callbacks */
+	unsigned int pointer_dma_reads;	/* snd_dma_pointer reads, the ISA DMA controller I/O */
+	struct snd_wss_stat_time wait_delay;	/* snd_wss_wait_delay, INIT polled with udelay */
+	unsigned int mce_cycles;	/* snd_wss_mce_up calls */
+	struct snd_wss_stat_time calib;	/* snd_wss_mce_down_finish, MCE down to ACI and INIT clear */
+	unsigned int calib_timeouts;	/* ACI or INIT still set at the end */
+	unsigned int init_read_timeouts;	/* reads done with INIT still set, 0x80 */
+	unsigned int irq_playback;	/* I24 PI seen by the interrupt handler */
+	unsigned int irq_capture;	/* I24 CI */
+	unsigned int irq_timer;		/* I24 TI */
+	unsigned int irq_unknown;	/* INT set without a known I24 bit */
+	unsigned int overrange_reads;	/* I11 reads by snd_wss_overrange */
+	unsigned int overrange_hits;	/* of those, above 0 dB */
+	struct snd_wss_stat_time hw_params;	/* playback and capture hw_params */
+	struct snd_wss_stat_time prepare;	/* playback and capture prepare */
+};
+
 struct snd_wss {
 	unsigned long port;		/* base i/o port */
 	struct resource *res_port;
@@ -85,11 +152,30 @@ struct snd_wss {
 
 	unsigned char image[32];	/* registers image */
 	unsigned char eimage[32];	/* extended registers image */
+	unsigned char cimage[16];	/* control registers image, software only on the 560z */
 	unsigned char mce_bit; /* keep track of the mode change enable state */
 	int calibrate_mute;
+	unsigned char paused;		/* I9 PEN/CEN of the paused streams */
+	unsigned char dma_lost;		/* paused streams whose 8237 setup a suspend lost */
+	unsigned char irq_status;	/* I24 bits left for snd_wss_irq_thread */
+	unsigned long overrange_next;	/* jiffies of the next overrange sample */
+	bool calibrated;	/* last MCE down auto-calibrated fine, image I8/I28 are in the codec */
 	int sw_3d_bit;
 	unsigned int p_dma_size;
 	unsigned int c_dma_size;
+	size_t p_ptr, c_ptr;		/* DMA position at pause or the last playback period */
+	u64 p_ptr_time;			/* local_clock() of the playback one */
+
+	unsigned int pending_regs;	/* I registers to write once INIT is cleared */
+	unsigned int pending_eregs;	/* same for X registers, by CS4236_REG() */
+	unsigned int mixer_regs;	/* I registers put by the mixer, not written yet */
+	unsigned int mixer_eregs;	/* same for X registers */
+	unsigned int dirty_regs;	/* I registers suspend dropped from the masks above */
+	unsigned int dirty_eregs;	/* same for X registers */
+	struct delayed_work pending_work;
+	struct work_struct calib_work;	/* waits for a calibration started in hw_params */
+	struct completion calib_done;
+	struct snd_wss_stats stats;
 
 	spinlock_t reg_lock;
 	struct mutex mce_mutex;
@@ -114,13 +200,30 @@ struct snd_wss {
 			    void *dma_private_data, int dma);
 };
 
+/* One (register, value) pair for snd_wss_out_batch() and snd_cs4236_ext_out_batch().
+ * reg is an I register index (0-31) for the first and a CS4236_I23VAL() X register
+ * address for the second, the same as for snd_wss_out() and snd_cs4236_ext_out(). */
+struct snd_wss_reg_val {
+	unsigned char reg;
+	unsigned char val;
+};
+
 /* exported functions */
 
 void snd_wss_out(struct snd_wss *chip, unsigned char reg, unsigned char val);
+void snd_wss_out_batch(struct snd_wss *chip,
+		       const struct snd_wss_reg_val *regs, unsigned int count);
 unsigned char snd_wss_in(struct snd_wss *chip, unsigned char reg);
 void snd_cs4236_ext_out(struct snd_wss *chip,
 			unsigned char reg, unsigned char val);
+void snd_wss_out_mixer(struct snd_wss *chip, unsigned char reg, unsigned char val);
+void snd_cs4236_ext_out_mixer(struct snd_wss *chip, unsigned char reg, unsigned char val);
+void snd_cs4236_ext_out_batch(struct snd_wss *chip,
+			      const struct snd_wss_reg_val *regs, unsigned int count);
 unsigned char snd_cs4236_ext_in(struct snd_wss *chip, unsigned char reg);
+bool snd_wss_codec_was_reset(struct snd_wss *chip);
+unsigned int snd_wss_image_regs(struct snd_wss *chip, struct snd_wss_reg_val *regs,
+				unsigned int skip, bool changed_only);
 void snd_wss_mce_up(struct snd_wss *chip);
 void snd_wss_mce_down(struct snd_wss *chip);
 
@@ -137,7 +240,9 @@ int snd_wss_create(struct snd_card *card,
 		      unsigned short hwshare,
 		      struct snd_wss **rchip);
 int snd_wss_pcm(struct snd_wss *chip, int device);
+#ifdef CONFIG_SND_WSS_TIMER
 int snd_wss_timer(struct snd_wss *chip, int device);
+#endif
 int snd_wss_mixer(struct snd_wss *chip);
 
 const struct snd_pcm_ops *snd_wss_get_pcm_ops(int direction);
@@ -150,6 +255,17 @@ int snd_cs4236_create(struct snd_card *card,
 		      struct snd_wss **rchip);
 int snd_cs4236_pcm(struct snd_wss *chip, int device);
 int snd_cs4236_mixer(struct snd_wss *chip);
+#ifdef CONFIG_SND_WSS_CS4237B_ONLY
+/* Called directly by wss_lib instead of through rate_constraint,
+ * set_playback_format and set_capture_format. */
+int snd_cs4236_xrate(struct snd_pcm_runtime *runtime);
+void snd_cs4236_playback_format(struct snd_wss *chip,
+				struct snd_pcm_hw_params *params,
+				unsigned char pdfr);
+void snd_cs4236_capture_format(struct snd_wss *chip,
+			       struct snd_pcm_hw_params *params,
+			       unsigned char cdfr);
+#endif
 
 /*
  *  mixer library
@@ -77,6 +77,13 @@ static int isa_registered;
 static int pnpc_registered;
 static int pnp_registered;
 
+/* The drivers prefer asynchronous probing so the codec probe and calibration
+ * don't hold up the other initcalls of the monolithic kernel: while
+ * snd_wss_busy_wait and the MCE msleeps sleep, the rest of the boot runs.
+ * The PnP detect functions hand out the card slots from a static counter, so
+ * they take this mutex. */
+static DEFINE_MUTEX(cs423x_probe_mutex);
+
 struct snd_card_cs4236 {
 	struct snd_wss *chip;
 	struct pnp_dev *wss;
@@ -283,7 +290,9 @@ static int snd_cs423x_probe(struct snd_card *card, int dev)
 {
 	struct snd_card_cs4236 *acard;
 	struct snd_wss *chip;
+#ifdef CONFIG_SND_CS4236_OPL3
 	struct snd_opl3 *opl3;
+#endif
 	int err;
 
 	acard = card->private_data;
@@ -304,7 +313,7 @@ static int snd_cs423x_probe(struct snd_card *card, int dev)
 		return err;
 
 	acard->chip = chip;
-	if (chip->hardware & WSS_HW_CS4236B_MASK) {
+	if (snd_wss_hardware(chip) & WSS_HW_CS4236B_MASK) {
 
 		err = snd_cs4236_pcm(chip, 0);
 		if (err < 0)
@@ -334,10 +343,15 @@ static int snd_cs423x_probe(struct snd_card *card, int dev)
 			  chip->pcm->name, chip->port, irq[dev], dma1[dev],
 			  dma2[dev]);
 
+#ifdef CONFIG_SND_CS4236_TIMER
 	err = snd_wss_timer(chip, 0);
 	if (err < 0)
 		return err;
+#endif
 
+	/* The 560z has no game port nor MIDI connector, so the FM and the
+	 * MPU-401 can be left out of the kernel. */
+#ifdef CONFIG_SND_CS4236_OPL3
 	if (fm_port[dev] > 0 && fm_port[dev] != SNDRV_AUTO_PORT) {
 		if (snd_opl3_create(card,
 				    fm_port[dev], fm_port[dev] + 2,
@@ -349,7 +363,9 @@ static int snd_cs423x_probe(struct snd_card *card, int dev)
 				return err;
 		}
 	}
+#endif
 
+#ifdef CONFIG_SND_CS4236_MPU401
 	if (mpu_port[dev] > 0 && mpu_port[dev] != SNDRV_AUTO_PORT) {
 		if (mpu_irq[dev] == SNDRV_AUTO_IRQ)
 			mpu_irq[dev] = -1;
@@ -358,6 +374,7 @@ static int snd_cs423x_probe(struct snd_card *card, int dev)
 					mpu_irq[dev], NULL) < 0)
 			dev_warn(card->dev, IDENT ": MPU401 not detected\n");
 	}
+#endif
 
 	return snd_card_register(card);
 }
@@ -436,7 +453,8 @@ static struct isa_driver cs423x_isa_driver = {
 	.resume		= snd_cs423x_isa_resume,
 #endif
 	.driver		= {
-		.name	= DEV_NAME
+		.name	= DEV_NAME,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	},
 };
 
@@ -452,6 +470,7 @@ static int snd_cs423x_pnpbios_detect(struct pnp_dev *pdev,
 	struct snd_card *card;
 	struct pnp_dev *iter;
 
+	guard(mutex)(&cs423x_probe_mutex);
 	if (pnp_device_is_isapnp(pdev))
 		return -ENOENT;	/* we have another procedure - card */
 	for (; dev < SNDRV_CARDS; dev++) {
@@ -521,6 +540,9 @@ static struct pnp_driver cs423x_pnp_driver = {
 	.suspend	= snd_cs423x_pnp_suspend,
 	.resume		= snd_cs423x_pnp_resume,
 #endif
+	.driver		= {
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
+	},
 };
 
 static int snd_cs423x_pnpc_detect(struct pnp_card_link *pcard,
@@ -530,6 +552,7 @@ static int snd_cs423x_pnpc_detect(struct pnp_card_link *pcard,
 	struct snd_card *card;
 	int res;
 
+	guard(mutex)(&cs423x_probe_mutex);
 	for ( ; dev < SNDRV_CARDS; dev++) {
 		if (enable[dev] && isapnp[dev])
 			break;
@@ -575,6 +598,9 @@ static struct pnp_card_driver cs423x_pnpc_driver = {
 	.suspend	= snd_cs423x_pnpc_suspend,
 	.resume		= snd_cs423x_pnpc_resume,
 #endif
+	/* Only covers cards showing up later: pnp_register_card_driver probes
+	 * the cards already there itself, synchronously. */
+	.link.driver.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 };
 
 /* 560z utilise cs423x_pnp_driver 
@@ -11,7 +11,8 @@
  *  - After the module has loaded, run "sudo alsactl init CS4237B" and then "alsamixer" to up the volumes.
  *    "sudo alsactl store CS4237B" can be used to save the alsa settings including the volumes.
  *    After a reboot, "sudo alsactl init CS4237B" and "sudo alsactl restore CS4237B" are needed for
- *    sound to be audible.
+ *    sound to be audible. With the driver built in, snd_cs4236.master_volume=100 and
+ *    snd_cs4236.pcm_volume=100 on the kernel command line do the same without alsa.
  *    I kept the control registers documentation in below, but it doesn't apply to the 560z.
  *
  *  Bugs:
@@ -76,6 +77,7 @@
 #include <linux/io.h>
 #include <linux/delay.h>
 #include <linux/init.h>
+#include <linux/moduleparam.h>
 #include <linux/time.h>
 #include <linux/wait.h>
 #include <sound/core.h>
@@ -88,25 +90,43 @@
  *
  */
 
-static const unsigned char snd_cs4236_ext_map[18] = {
-	/* CS4236_LEFT_LINE */		0xff,
-	/* CS4236_RIGHT_LINE */		0xff,
-	/* CS4236_LEFT_MIC */		0xdf,
-	/* CS4236_RIGHT_MIC */		0xdf,
-	/* CS4236_LEFT_MIX_CTRL */	0xe0 | 0x18,
-	/* CS4236_RIGHT_MIX_CTRL */	0xe0,
-	/* CS4236_LEFT_FM */		0xbf,
-	/* CS4236_RIGHT_FM */		0xbf,
-	/* CS4236_LEFT_DSP */		0xbf,
-	/* CS4236_RIGHT_DSP */		0xbf,
-	/* CS4236_RIGHT_LOOPBACK */	0xbf,
-	/* CS4236_DAC_MUTE */		0xe0,
-	/* CS4236_ADC_RATE */		0x01,	/* 48kHz */
-	/* CS4236_DAC_RATE */		0x01,	/* 48kHz */
-	/* CS4236_LEFT_MASTER */	0xbf,
-	/* CS4236_RIGHT_MASTER */	0xbf,
-	/* CS4236_LEFT_WAVE */		0xbf,
-	/* CS4236_RIGHT_WAVE */		0xbf
+static const struct snd_wss_reg_val snd_cs4236_ext_map[18] = {
+	{ CS4236_LEFT_LINE,		0xff },
+	{ CS4236_RIGHT_LINE,		0xff },
+	{ CS4236_LEFT_MIC,		0xdf },
+	{ CS4236_RIGHT_MIC,		0xdf },
+	{ CS4236_LEFT_MIX_CTRL,		0xe0 | 0x18 },
+	{ CS4236_RIGHT_MIX_CTRL,	0xe0 },
+	{ CS4236_LEFT_FM,		0xbf },
+	{ CS4236_RIGHT_FM,		0xbf },
+	{ CS4236_LEFT_DSP,		0xbf },
+	{ CS4236_RIGHT_DSP,		0xbf },
+	{ CS4236_RIGHT_LOOPBACK,	0xbf },
+	{ CS4236_DAC_MUTE,		0xe0 },
+	{ CS4236_ADC_RATE,		0x01 },	/* 48kHz */
+	{ CS4236_DAC_RATE,		0x01 },	/* 48kHz */
+	{ CS4236_LEFT_MASTER,		0xbf },
+	{ CS4236_RIGHT_MASTER,		0xbf },
+	{ CS4236_LEFT_WAVE,		0xbf },
+	{ CS4236_RIGHT_WAVE,		0xbf }
+};
+
+/* Compatible but more featured registers. RIGHT_LINE_IN used to be written twice
+ * here; once is enough. */
+static const struct snd_wss_reg_val snd_cs4236_compat_map[] = {
+	{ CS4231_LEFT_INPUT,		0x40 },
+	{ CS4231_RIGHT_INPUT,		0x40 },
+	{ CS4231_AUX1_LEFT_INPUT,	0xff },
+	{ CS4231_AUX1_RIGHT_INPUT,	0xff },
+	{ CS4231_AUX2_LEFT_INPUT,	0xdf },
+	{ CS4231_AUX2_RIGHT_INPUT,	0xdf },
+	{ CS4231_LEFT_LINE_IN,		0xff },
+	{ CS4231_RIGHT_LINE_IN,		0xff }
+};
+
+static const struct snd_wss_reg_val snd_cs4235_master_map[] = {
+	{ CS4235_LEFT_MASTER,		0xff },
+	{ CS4235_RIGHT_MASTER,		0xff }
 };
 
 /* Read the indirect registers one by one. */
@@ -161,7 +181,16 @@ static const struct snd_pcm_hw_constraint_ratnums hw_constraints_clocks = {
 	.rats = clocks,
 };
 
-static int snd_cs4236_xrate(struct snd_pcm_runtime *runtime)
+/* wss_lib calls these directly instead of through chip->rate_constraint,
+ * chip->set_playback_format and chip->set_capture_format in CS4237B only
+ * builds. */
+#ifdef CONFIG_SND_WSS_CS4237B_ONLY
+#define CS4236_FORMAT_FN
+#else
+#define CS4236_FORMAT_FN	static
+#endif
+
+CS4236_FORMAT_FN int snd_cs4236_xrate(struct snd_pcm_runtime *runtime)
 {
 	return snd_pcm_hw_constraint_ratnums(runtime, 0, SNDRV_PCM_HW_PARAM_RATE,
 					     &hw_constraints_clocks);
@@ -186,13 +215,19 @@ static unsigned char divisor_to_rate_register(unsigned int divisor)
 	}
 }
 
-static void snd_cs4236_playback_format(struct snd_wss *chip,
-				       struct snd_pcm_hw_params *params,
-				       unsigned char pdfr)
+CS4236_FORMAT_FN void snd_cs4236_playback_format(struct snd_wss *chip,
+						struct snd_pcm_hw_params *params,
+						unsigned char pdfr)
 {
 	unsigned char rate = divisor_to_rate_register(params->rate_den);
 	
 	guard(spinlock_irqsave)(&chip->reg_lock);
+	/* Reopening with the same format costs no port I/O. The images are what's in
+	 * the codec once snd_wss_init calibrated it. */
+	if (chip->calibrated &&
+	    chip->image[CS4231_PLAYBK_FORMAT] == (pdfr & 0xf0) &&
+	    chip->eimage[CS4236_REG(CS4236_DAC_RATE)] == rate)
+		return;
 	/* set fast playback format change and clean playback FIFO */
 	snd_wss_out(chip, CS4231_ALT_FEATURE_1,
 		    chip->image[CS4231_ALT_FEATURE_1] | 0x10);
@@ -202,13 +237,17 @@ static void snd_cs4236_playback_format(struct snd_wss *chip,
 	snd_cs4236_ext_out(chip, CS4236_DAC_RATE, rate);
 }
 
-static void snd_cs4236_capture_format(struct snd_wss *chip,
-				      struct snd_pcm_hw_params *params,
-				      unsigned char cdfr)
+CS4236_FORMAT_FN void snd_cs4236_capture_format(struct snd_wss *chip,
+					       struct snd_pcm_hw_params *params,
+					       unsigned char cdfr)
 {
 	unsigned char rate = divisor_to_rate_register(params->rate_den);
 	
 	guard(spinlock_irqsave)(&chip->reg_lock);
+	if (chip->calibrated &&
+	    chip->image[CS4231_REC_FORMAT] == (cdfr & 0xf0) &&
+	    chip->eimage[CS4236_REG(CS4236_ADC_RATE)] == rate)
+		return;
 	/* set fast capture format change and clean capture FIFO */
 	snd_wss_out(chip, CS4231_ALT_FEATURE_1,
 		    chip->image[CS4231_ALT_FEATURE_1] | 0x20);
@@ -220,42 +259,115 @@ static void snd_cs4236_capture_format(struct snd_wss *chip,
 
 #ifdef CONFIG_PM
 
-static void snd_cs4236_suspend(struct snd_wss *chip)
-{
-	int reg;
-	
-	guard(spinlock_irqsave)(&chip->reg_lock);
-	for (reg = 0; reg < 32; reg++)
-		chip->image[reg] = snd_wss_in(chip, reg);
-	for (reg = 0; reg < 18; reg++)
-		chip->eimage[reg] = snd_cs4236_ext_in(chip, CS4236_I23VAL(reg));
-}
+/* X0-X17 after RESDRV, from the CS4237B datasheet. Bits documented as
+ * undefined (x) are taken as 0. */
+static const unsigned char snd_cs4236_reset_eimage[18] = {
+	/* CS4236_LEFT_LINE */		0xe8,
+	/* CS4236_RIGHT_LINE */		0xe8,
+	/* CS4236_LEFT_MIC */		0xcf,
+	/* CS4236_RIGHT_MIC */		0xcf,
+	/* CS4236_LEFT_MIX_CTRL */	0x84,
+	/* CS4236_RIGHT_MIX_CTRL */	0x00,
+	/* CS4236_LEFT_FM */		0x80,
+	/* CS4236_RIGHT_FM */		0x80,
+	/* CS4236_LEFT_DSP */		0x00,
+	/* CS4236_RIGHT_DSP */		0x00,
+	/* CS4236_RIGHT_LOOPBACK */	0x3f,
+	/* CS4236_DAC_MUTE */		0xc0,
+	/* CS4236_ADC_RATE */		0x00,	/* undefined */
+	/* CS4236_DAC_RATE */		0x00,	/* undefined */
+	/* CS4236_LEFT_MASTER */	0x00,
+	/* CS4236_RIGHT_MASTER */	0x00,
+	/* CS4236_LEFT_WAVE */		0x00,
+	/* CS4236_RIGHT_WAVE */		0x00
+};
 
+/* The suspend callback stays snd_wss_suspend: chip->eimage is kept up to date by
+ * snd_cs4236_ext_out and snd_cs4236_ext_out_batch, so nothing is read back.
+ * What a stream needs to resume in place comes back from the images here when
+ * the codec lost it: the I8/I28 format, the X12/X13 rates and the I14/I15,
+ * I30/I31 counts. The 8237 is programmed again by the RESUME trigger. */
 static void snd_cs4236_resume(struct snd_wss *chip)
 {
+	struct snd_wss_reg_val regs[32], eregs[18];
+	unsigned int count, ecount = 0;
+	bool was_reset = snd_wss_codec_was_reset(chip);
 	int reg;
-	
+
 	snd_wss_mce_up(chip);
 	scoped_guard(spinlock_irqsave, &chip->reg_lock) {
-		for (reg = 0; reg < 32; reg++) {
-			switch (reg) {
-			case CS4236_EXT_REG:
-			case CS4231_VERSION:
-			case 27:	/* why? CS4235 - master left */
-			case 29:	/* why? CS4235 - master right */
-				break;
-			default:
-				snd_wss_out(chip, reg, chip->image[reg]);
-				break;
-			}
+		/* Only write back what differs from the reset values when the
+		 * codec lost its registers. The rates have no reset value.
+		 * When it kept them, only what suspend dropped is missing. */
+		count = snd_wss_image_regs(chip, regs,
+					   BIT(27) | BIT(29) |	/* why? CS4235 - master left/right */
+					   (was_reset ? 0 : ~chip->dirty_regs),
+					   was_reset);
+		for (reg = 0; reg < 18; reg++) {
+			if (!was_reset && !(chip->dirty_eregs & BIT(reg)))
+				continue;
+			if (was_reset && reg != CS4236_REG(CS4236_ADC_RATE) &&
+			    reg != CS4236_REG(CS4236_DAC_RATE) &&
+			    chip->eimage[reg] == snd_cs4236_reset_eimage[reg])
+				continue;
+			eregs[ecount].reg = CS4236_I23VAL(reg);
+			eregs[ecount++].val = chip->eimage[reg];
 		}
-		for (reg = 0; reg < 18; reg++)
-			snd_cs4236_ext_out(chip, CS4236_I23VAL(reg), chip->eimage[reg]);
+		chip->dirty_regs = 0;
+		chip->dirty_eregs = 0;
+		snd_wss_out_batch(chip, regs, count);
+		snd_cs4236_ext_out_batch(chip, eregs, ecount);
 	}
 	snd_wss_mce_down(chip);
 }
 
 #endif /* CONFIG_PM */
+
+/* The master and PCM levels are muted by the maps above until something in
+ * userspace restores them. With the driver built in, these let the kernel
+ * command line set them instead (snd_cs4236.master_volume=100
+ * snd_cs4236.pcm_volume=100) so the 560z makes sound without loading
+ * alsa-config, alsa and running "alsactl restore CS4237B" at every boot.
+ * They are in percent of the mixer control ranges; -1 leaves the level muted.
+ * The 3D controls live in the C registers behind the control port the 560z
+ * doesn't have, so there's nothing to set for them here. */
+static int master_volume = -1;
+module_param(master_volume, int, 0444);
+MODULE_PARM_DESC(master_volume, "Master digital volume in percent set at probe (-1 = muted).");
+static int pcm_volume = -1;
+module_param(pcm_volume, int, 0444);
+MODULE_PARM_DESC(pcm_volume, "PCM playback volume in percent set at probe (-1 = muted).");
+
+static inline int snd_cs4236_mixer_master_digital_invert_volume(int vol)
+{
+	return (vol < 64) ? 63 - vol : 64 + (71 - vol);
+}
+
+/* Same values the "Master Digital" and "PCM Playback" controls would write,
+ * with the mute bits cleared. Called under reg_lock. */
+static void snd_cs4236_default_levels(struct snd_wss *chip)
+{
+	struct snd_wss_reg_val regs[2], eregs[2];
+	unsigned char val;
+
+	if (pcm_volume >= 0) {
+		val = 63 - min(pcm_volume, 100) * 63 / 100;
+		regs[0].reg = CS4231_LEFT_OUTPUT;
+		regs[0].val = (chip->image[CS4231_LEFT_OUTPUT] & ~0xbf) | val;
+		regs[1].reg = CS4231_RIGHT_OUTPUT;
+		regs[1].val = (chip->image[CS4231_RIGHT_OUTPUT] & ~0xbf) | val;
+		snd_wss_out_batch(chip, regs, ARRAY_SIZE(regs));
+	}
+	if (master_volume >= 0) {
+		val = snd_cs4236_mixer_master_digital_invert_volume(min(master_volume, 100) * 71 / 100);
+		eregs[0].reg = CS4236_LEFT_MASTER;
+		eregs[0].val = val;
+		eregs[1].reg = CS4236_RIGHT_MASTER;
+		eregs[1].val = val;
+		snd_cs4236_ext_out_batch(chip, eregs, ARRAY_SIZE(eregs));
+	}
+}
+
 /*
  * This function does no fail if the chip is not CS4236B or compatible.
  * It just an equivalent to the snd_wss_create() then.
@@ -270,7 +382,6 @@ int snd_cs4236_create(struct snd_card *card,
 {
 	struct snd_wss *chip;
 	unsigned char version;
-	unsigned int reg;
 	int err;
 
 	*rchip = NULL;
@@ -284,7 +395,7 @@ int snd_cs4236_create(struct snd_card *card,
 	if (err < 0)
 		return err;
 
-	if ((chip->hardware & WSS_HW_CS4236B_MASK) == 0) {
+	if ((snd_wss_hardware(chip) & WSS_HW_CS4236B_MASK) == 0) {
 		dev_dbg(card->dev, "chip is not CS4236+, hardware=0x%x\n",
 			chip->hardware);
 		*rchip = chip;
@@ -317,37 +428,29 @@ int snd_cs4236_create(struct snd_card *card,
 	version = snd_cs4236_ext_in(chip, CS4236_VERSION);
 	decode_version(card, version);
 
-	reg = ((IEC958_AES1_CON_PCM_CODER & 3) << 6) |
-	      IEC958_AES0_CON_EMPHASIS_NONE;
 	chip->rate_constraint = snd_cs4236_xrate;
 	chip->set_playback_format = snd_cs4236_playback_format;
 	chip->set_capture_format = snd_cs4236_capture_format;
 #ifdef CONFIG_PM
-	chip->suspend = snd_cs4236_suspend;
 	chip->resume = snd_cs4236_resume;
 #endif
 
-	/* initialize extended registers */
-	for (reg = 0; reg < sizeof(snd_cs4236_ext_map); reg++)
-		snd_cs4236_ext_out(chip, CS4236_I23VAL(reg),
-				   snd_cs4236_ext_map[reg]);
-
-	/* initialize compatible but more featured registers */
-	snd_wss_out(chip, CS4231_LEFT_INPUT, 0x40);
-	snd_wss_out(chip, CS4231_RIGHT_INPUT, 0x40);
-	snd_wss_out(chip, CS4231_AUX1_LEFT_INPUT, 0xff);
-	snd_wss_out(chip, CS4231_AUX1_RIGHT_INPUT, 0xff);
-	snd_wss_out(chip, CS4231_AUX2_LEFT_INPUT, 0xdf);
-	snd_wss_out(chip, CS4231_AUX2_RIGHT_INPUT, 0xdf);
-	snd_wss_out(chip, CS4231_RIGHT_LINE_IN, 0xff);
-	snd_wss_out(chip, CS4231_LEFT_LINE_IN, 0xff);
-	snd_wss_out(chip, CS4231_RIGHT_LINE_IN, 0xff);
-	switch (chip->hardware) {
-	case WSS_HW_CS4235:
-	case WSS_HW_CS4239:
-		snd_wss_out(chip, CS4235_LEFT_MASTER, 0xff);
-		snd_wss_out(chip, CS4235_RIGHT_MASTER, 0xff);
-		break;
+	scoped_guard(spinlock_irqsave, &chip->reg_lock) {
+		/* initialize extended registers */
+		snd_cs4236_ext_out_batch(chip, snd_cs4236_ext_map,
+					 ARRAY_SIZE(snd_cs4236_ext_map));
+
+		/* initialize compatible but more featured registers */
+		snd_wss_out_batch(chip, snd_cs4236_compat_map,
+				  ARRAY_SIZE(snd_cs4236_compat_map));
+		switch (snd_wss_hardware(chip)) {
+		case WSS_HW_CS4235:
+		case WSS_HW_CS4239:
+			snd_wss_out_batch(chip, snd_cs4235_master_map,
+					  ARRAY_SIZE(snd_cs4235_master_map));
+			break;
+		}
+		snd_cs4236_default_levels(chip);
 	}
 
 	*rchip = chip;
@@ -426,36 +529,58 @@ static int snd_cs4236_put_single(struct snd_kcontrol *kcontrol, struct snd_ctl_e
 	guard(spinlock_irqsave)(&chip->reg_lock);
 	val = (chip->eimage[CS4236_REG(reg)] & ~(mask << shift)) | val;
 	change = val != chip->eimage[CS4236_REG(reg)];
-	snd_cs4236_ext_out(chip, reg, val);
+	snd_cs4236_ext_out_mixer(chip, reg, val);
 	return change;
 }
 
+#if defined(CONFIG_SND_CS4236_IEC958) || defined(CONFIG_SND_CS4236_3D)
 #define CS4236_SINGLEC(xname, xindex, reg, shift, mask, invert) \
 { .iface = SNDRV_CTL_ELEM_IFACE_MIXER, .name = xname, .index = xindex, \
   .info = snd_cs4236_info_single, \
   .get = snd_cs4236_get_singlec, .put = snd_cs4236_put_singlec, \
   .private_value = reg | (shift << 8) | (mask << 16) | (invert << 24) }
 
-/* I think the c at the end of this method name refers to the control device. Since
- * there is no control device on the 560z, I believe this is not needed and could be removed. */
+/* The c at the end refers to the control device (C registers). There is no control
+ * port on the 560z, so these only keep the values in chip->cimage. That's enough
+ * for the get to return what was put and for the put to report a real change,
+ * so a no-op alsactl restore doesn't send a change event to every listener. */
 static int snd_cs4236_get_singlec(struct snd_kcontrol *kcontrol, struct snd_ctl_elem_value *ucontrol)
 {
+	struct snd_wss *chip = snd_kcontrol_chip(kcontrol);
+	int reg = kcontrol->private_value & 0xff;
+	int shift = (kcontrol->private_value >> 8) & 0xff;
 	int mask = (kcontrol->private_value >> 16) & 0xff;
 	int invert = (kcontrol->private_value >> 24) & 0xff;
-	/* I removed code which was using cimage since cimage was removed since there's no control device on the 560z */
+
+	guard(spinlock_irqsave)(&chip->reg_lock);
+	ucontrol->value.integer.value[0] = (chip->cimage[reg] >> shift) & mask;
 	if (invert)
 		ucontrol->value.integer.value[0] = mask - ucontrol->value.integer.value[0];
 	return 0;
 }
 
-/* I think the c at the end of this method name refers to the control device. Since
- * there is no control device on the 560z, I believe this is not needed and could be removed. */
 static int snd_cs4236_put_singlec(struct snd_kcontrol *kcontrol, struct snd_ctl_elem_value *ucontrol)
 {
-	/* I removed code which was using cimage since cimage was removed since there's no control device on the 560z */
-	/* Always returning 1 since there's no cimage anymore and no way to know if there was a change or not. */
-	return 1;
+	struct snd_wss *chip = snd_kcontrol_chip(kcontrol);
+	int reg = kcontrol->private_value & 0xff;
+	int shift = (kcontrol->private_value >> 8) & 0xff;
+	int mask = (kcontrol->private_value >> 16) & 0xff;
+	int invert = (kcontrol->private_value >> 24) & 0xff;
+	int change;
+	unsigned short val;
+
+	val = (ucontrol->value.integer.value[0] & mask);
+	if (invert)
+		val = mask - val;
+	val <<= shift;
+	guard(spinlock_irqsave)(&chip->reg_lock);
+	val = (chip->cimage[reg] & ~(mask << shift)) | val;
+	change = val != chip->cimage[reg];
+	/* snd_cs4236_ctrl_out was here; nothing to write without the control port. */
+	chip->cimage[reg] = val;
+	return change;
 }
+#endif
 
 #define CS4236_DOUBLE(xname, xindex, left_reg, right_reg, shift_left, shift_right, mask, invert) \
 { .iface = SNDRV_CTL_ELEM_IFACE_MIXER, .name = xname, .index = xindex, \
@@ -529,12 +654,12 @@ static int snd_cs4236_put_double(struct snd_kcontrol *kcontrol, struct snd_ctl_e
 		val1 = (chip->eimage[CS4236_REG(left_reg)] & ~(mask << shift_left)) | val1;
 		val2 = (chip->eimage[CS4236_REG(right_reg)] & ~(mask << shift_right)) | val2;
 		change = val1 != chip->eimage[CS4236_REG(left_reg)] || val2 != chip->eimage[CS4236_REG(right_reg)];
-		snd_cs4236_ext_out(chip, left_reg, val1);
-		snd_cs4236_ext_out(chip, right_reg, val2);
+		snd_cs4236_ext_out_mixer(chip, left_reg, val1);
+		snd_cs4236_ext_out_mixer(chip, right_reg, val2);
 	} else {
 		val1 = (chip->eimage[CS4236_REG(left_reg)] & ~((mask << shift_left) | (mask << shift_right))) | val1 | val2;
 		change = val1 != chip->eimage[CS4236_REG(left_reg)];
-		snd_cs4236_ext_out(chip, left_reg, val1);
+		snd_cs4236_ext_out_mixer(chip, left_reg, val1);
 	}
 	return change;
 }
@@ -600,8 +725,8 @@ static int snd_cs4236_put_double1(struct snd_kcontrol *kcontrol, struct snd_ctl_
 	val1 = (chip->image[left_reg] & ~(mask << shift_left)) | val1;
 	val2 = (chip->eimage[CS4236_REG(right_reg)] & ~(mask << shift_right)) | val2;
 	change = val1 != chip->image[left_reg] || val2 != chip->eimage[CS4236_REG(right_reg)];
-	snd_wss_out(chip, left_reg, val1);
-	snd_cs4236_ext_out(chip, right_reg, val2);
+	snd_wss_out_mixer(chip, left_reg, val1);
+	snd_cs4236_ext_out_mixer(chip, right_reg, val2);
 	return change;
 }
 
@@ -613,11 +738,6 @@ static int snd_cs4236_put_double1(struct snd_kcontrol *kcontrol, struct snd_ctl_
   .private_value = 71 << 24, \
   .tlv = { .p = (xtlv) } }
 
-static inline int snd_cs4236_mixer_master_digital_invert_volume(int vol)
-{
-	return (vol < 64) ? 63 - vol : 64 + (71 - vol);
-}
-
 static int snd_cs4236_get_master_digital(struct snd_kcontrol *kcontrol, struct snd_ctl_elem_value *ucontrol)
 {
 	struct snd_wss *chip = snd_kcontrol_chip(kcontrol);
@@ -640,8 +760,8 @@ static int snd_cs4236_put_master_digital(struct snd_kcontrol *kcontrol, struct s
 	val1 = (chip->eimage[CS4236_REG(CS4236_LEFT_MASTER)] & ~0x7f) | val1;
 	val2 = (chip->eimage[CS4236_REG(CS4236_RIGHT_MASTER)] & ~0x7f) | val2;
 	change = val1 != chip->eimage[CS4236_REG(CS4236_LEFT_MASTER)] || val2 != chip->eimage[CS4236_REG(CS4236_RIGHT_MASTER)];
-	snd_cs4236_ext_out(chip, CS4236_LEFT_MASTER, val1);
-	snd_cs4236_ext_out(chip, CS4236_RIGHT_MASTER, val2);
+	snd_cs4236_ext_out_mixer(chip, CS4236_LEFT_MASTER, val1);
+	snd_cs4236_ext_out_mixer(chip, CS4236_RIGHT_MASTER, val2);
 	return change;
 }
 
@@ -697,8 +817,8 @@ static int snd_cs4235_put_output_accu(struct snd_kcontrol *kcontrol, struct snd_
 	val1 = (chip->image[CS4235_LEFT_MASTER] & ~(3 << 5)) | val1;
 	val2 = (chip->image[CS4235_RIGHT_MASTER] & ~(3 << 5)) | val2;
 	change = val1 != chip->image[CS4235_LEFT_MASTER] || val2 != chip->image[CS4235_RIGHT_MASTER];
-	snd_wss_out(chip, CS4235_LEFT_MASTER, val1);
-	snd_wss_out(chip, CS4235_RIGHT_MASTER, val2);
+	snd_wss_out_mixer(chip, CS4235_LEFT_MASTER, val1);
+	snd_wss_out_mixer(chip, CS4235_RIGHT_MASTER, val2);
 	return change;
 }
 
@@ -875,6 +995,7 @@ WSS_DOUBLE("Analog Loopback Switch", 0,
 		CS4231_LEFT_INPUT, CS4231_RIGHT_INPUT, 7, 7, 1, 0),
 };
 
+#ifdef CONFIG_SND_CS4236_IEC958
 #define CS4236_IEC958_ENABLE(xname, xindex) \
 { .iface = SNDRV_CTL_ELEM_IFACE_MIXER, .name = xname, .index = xindex, \
   .info = snd_cs4236_info_single, \
@@ -914,8 +1035,9 @@ static int snd_cs4236_put_iec958_switch(struct snd_kcontrol *kcontrol, struct sn
 		val = (chip->image[CS4231_ALT_FEATURE_1] & ~0x0e) | (0<<2) | (enable << 1);
 		change = val != chip->image[CS4231_ALT_FEATURE_1];
 		snd_wss_out(chip, CS4231_ALT_FEATURE_1, val);
-		udelay(100);
 	}
+	/* Give the codec its 100 us with interrupts on. */
+	udelay(100);
 	snd_wss_mce_down(chip);
 
 #if 0
@@ -939,7 +1061,9 @@ CS4236_SINGLEC("IEC958 Output CSBR", 0, 4, 6, 1, 0),
 CS4236_SINGLEC("IEC958 Output Channel Status Low", 0, 5, 1, 127, 0),
 CS4236_SINGLEC("IEC958 Output Channel Status High", 0, 6, 0, 255, 0)
 };
+#endif /* CONFIG_SND_CS4236_IEC958 */
 
+#ifdef CONFIG_SND_CS4236_3D
 static const struct snd_kcontrol_new snd_cs4236_3d_controls_cs4235[] = {
 CS4236_SINGLEC("3D Control - Switch", 0, 3, 4, 1, 0),
 CS4236_SINGLEC("3D Control - Space", 0, 2, 4, 15, 1)
@@ -959,21 +1083,25 @@ CS4236_SINGLEC("3D Control - Space", 0, 2, 4, 15, 1),
 CS4236_SINGLEC("3D Control - Volume", 0, 2, 0, 15, 1),
 CS4236_SINGLEC("3D Control - IEC958", 0, 3, 5, 1, 0)
 };
+#endif /* CONFIG_SND_CS4236_3D */
 
 int snd_cs4236_mixer(struct snd_wss *chip)
 {
 	struct snd_card *card;
-	unsigned int idx, count;
+	unsigned int idx;
 	int err;
+#ifdef CONFIG_SND_CS4236_3D
+	unsigned int count;
 	const struct snd_kcontrol_new *kcontrol;
+#endif
 
 	if (snd_BUG_ON(!chip || !chip->card))
 		return -EINVAL;
 	card = chip->card;
 	strscpy(card->mixername, snd_wss_chip_id(chip));
 
-	if (chip->hardware == WSS_HW_CS4235 ||
-	    chip->hardware == WSS_HW_CS4239) {
+	if (snd_wss_hardware(chip) == WSS_HW_CS4235 ||
+	    snd_wss_hardware(chip) == WSS_HW_CS4239) {
 		for (idx = 0; idx < ARRAY_SIZE(snd_cs4235_controls); idx++) {
 			err = snd_ctl_add(card, snd_ctl_new1(&snd_cs4235_controls[idx], chip));
 			if (err < 0)
@@ -986,7 +1114,8 @@ int snd_cs4236_mixer(struct snd_wss *chip)
 				return err;
 		}
 	}
-	switch (chip->hardware) {
+#ifdef CONFIG_SND_CS4236_3D
+	switch (snd_wss_hardware(chip)) {
 	case WSS_HW_CS4235:
 	case WSS_HW_CS4239:
 		count = ARRAY_SIZE(snd_cs4236_3d_controls_cs4235);
@@ -1009,13 +1138,16 @@ int snd_cs4236_mixer(struct snd_wss *chip)
 		if (err < 0)
 			return err;
 	}
-	if (chip->hardware == WSS_HW_CS4237B ||
-	    chip->hardware == WSS_HW_CS4238B) {
+#endif
+#ifdef CONFIG_SND_CS4236_IEC958
+	if (snd_wss_hardware(chip) == WSS_HW_CS4237B ||
+	    snd_wss_hardware(chip) == WSS_HW_CS4238B) {
 		for (idx = 0; idx < ARRAY_SIZE(snd_cs4236_iec958_controls); idx++) {
 			err = snd_ctl_add(card, snd_ctl_new1(&snd_cs4236_iec958_controls[idx], chip));
 			if (err < 0)
 				return err;
 		}
 	}
+#endif
 	return 0;
 }
@@ -19,11 +19,14 @@
 #include <linux/pm.h>
 #include <linux/init.h>
 #include <linux/interrupt.h>
+#include <linux/iopoll.h>
 #include <linux/slab.h>
 #include <linux/ioport.h>
 #include <linux/module.h>
 #include <linux/io.h>
+#include <linux/sched/clock.h>
 #include <sound/core.h>
+#include <sound/info.h>
 #include <sound/wss.h>
 #include <sound/pcm_params.h>
 #include <sound/tlv.h>
@@ -31,10 +34,22 @@
 #include <asm/dma.h>
 #include <asm/irq.h>
 
+#define CREATE_TRACE_POINTS
+#include "wss_trace.h"
+
 MODULE_AUTHOR("Jaroslav Kysela <perex@perex.cz>");
 MODULE_DESCRIPTION("Routines for control of CS4231(A)/CS4232/InterWave & compatible chips");
 MODULE_LICENSE("GPL");
 
+/* Built in, this is snd_wss_lib.threaded_irq=1 on the kernel command line. */
+static bool threaded_irq;
+module_param(threaded_irq, bool, 0444);
+MODULE_PARM_DESC(threaded_irq, "Notify periods and timer ticks from an IRQ thread.");
+
+static bool interpolate_pointer;
+module_param(interpolate_pointer, bool, 0444);
+MODULE_PARM_DESC(interpolate_pointer, "Move the playback pointer on from the last period interrupt instead of reading the DMA controller.");
+
 /*
  *  Some variables
  */
@@ -109,6 +124,7 @@ static const unsigned char snd_wss_original_image[32] =
 	0x00,			/* 1f/31 - cbrl */
 };
 
+#ifndef CONFIG_SND_WSS_CS4237B_ONLY
 static const unsigned char snd_opti93x_original_image[32] =
 {
 	0x00,		/* 00/00 - l_mixout_outctrl */
@@ -144,6 +160,112 @@ static const unsigned char snd_opti93x_original_image[32] =
 	0x00,		/* 1e/30 - cap_upcount_reg */
 	0x00		/* 1f/31 - cap_lowcount_reg */
 };
+#endif
+
+/* CS4237B register values after RESDRV, from the datasheet. Bits documented as
+ * undefined (x) are taken as 0. chip->image is the register cache; these are the
+ * defaults it is compared to when the codec comes back from a reset. */
+static const unsigned char snd_wss_reset_image[32] =
+{
+	0x00,			/* 00/00 - lic */
+	0x00,			/* 01/01 - ric */
+	0xe8,			/* 02/02 - la1ic */
+	0xe8,			/* 03/03 - ra1ic */
+	0xc8,			/* 04/04 - la2ic */
+	0xc8,			/* 05/05 - ra2ic */
+	0x80,			/* 06/06 - loc */
+	0x80,			/* 07/07 - roc */
+	0x00,			/* 08/08 - pdfr */
+	CS4231_AUTOCALIB,	/* 09/09 - ic */
+	0x00,			/* 0a/10 - pc */
+	0x00,			/* 0b/11 - ti */
+	0x8a,			/* 0c/12 - mi, MODE 1 */
+	0x00,			/* 0d/13 - lbc */
+	0x00,			/* 0e/14 - pbru */
+	0x00,			/* 0f/15 - pbrl */
+	0x00,			/* 10/16 - afei */
+	0x00,			/* 11/17 - afeii */
+	0x00,			/* 12/18 - llic, undefined */
+	0x00,			/* 13/19 - rlic, undefined */
+	0x00,			/* 14/20 - tlb */
+	0x00,			/* 15/21 - thb */
+	0x00,			/* 16/22 - asfs */
+	0x00,			/* 17/23 - xra */
+	0x00,			/* 18/24 - afs */
+	0x03,			/* 19/25 - version */
+	0xa0,			/* 1a/26 - mioc */
+	0x00,			/* 1b/27 - reserved, undefined */
+	0x00,			/* 1c/28 - cdfr */
+	0x00,			/* 1d/29 - reserved, undefined */
+	0x00,			/* 1e/30 - cbru */
+	0x00,			/* 1f/31 - cbrl */
+};
+
+/* I11 and I24 are status registers, I25 is the version and I23 is the
+ * extended register address/data port; they are never written back. */
+#define WSS_VOLATILE_REGS	(BIT(CS4231_TEST_INIT) | BIT(CS4236_EXT_REG) | \
+				 BIT(CS4231_IRQ_STATUS) | BIT(CS4231_VERSION))
+/* These have no defined value after a reset so they are always written back. */
+#define WSS_NO_DEFAULT_REGS	(BIT(CS4231_LEFT_LINE_IN) | BIT(CS4231_RIGHT_LINE_IN) | \
+				 BIT(27) | BIT(29))
+
+/*
+ *  Interrupts-off budget
+ *
+ *  Almost every register access is done with reg_lock held and interrupts off.
+ *  The 560z has a single Pentium II, so while we spin there the timer tick, the
+ *  keyboard and the PCMCIA NIC all wait. snd_wss_wait used to poll INIT up to
+ *  250 x 100 us = 25 ms in there.
+ *
+ *  Now INIT is polled at most WSS_INIT_SPIN_POLLS times, WSS_INIT_SPIN_US apart,
+ *  while the lock is held. If INIT is still set, the value only goes in the image,
+ *  the register is marked pending and snd_wss_pending_work writes it later from
+ *  process context. Once something is pending, later writes are queued behind it
+ *  so they can't overtake it.
+ *
+ *  With about 1 us per ISA I/O cycle, the worst cases with interrupts off are:
+ *    snd_wss_out, snd_wss_in       1 + 5 x (10 + 1) + 2 I/O      ~  60 us
+ *    snd_cs4236_ext_out/ext_in     same plus one more write      ~  60 us
+ *    snd_wss_out_batch(n)          60 + 2 x n                    ~ 124 us for 32
+ *    snd_cs4236_ext_out_batch(n)   60 + 3 x n                    ~ 114 us for 18
+ *    snd_wss_mce_up/down           2 I/O                         ~   2 us
+ *    snd_wss_trigger               one snd_wss_out, more on RESUME ~ 60 us
+ *  WSS_IRQOFF_BUDGET_US is the budget. The longest time measured for each of
+ *  these since the card was created is in /proc/asound/cardX/wss_stats. The
+ *  times are in ns; multiplied by the CPU clock in GHz they give the cycles,
+ *  which is how the trigger and interrupt paths of a CONFIG_SND_WSS_CS4237B_ONLY
+ *  build compare to a generic one.
+ */
+#define WSS_INIT_SPIN_POLLS	5
+#define WSS_INIT_SPIN_US	10
+#define WSS_IRQOFF_BUDGET_US	200
+
+/* The registers snd_wss_calibrate_mute mutes. */
+#define WSS_MUTE_REGS	(GENMASK(CS4231_RIGHT_OUTPUT, CS4231_LEFT_INPUT) | \
+			 BIT(CS4231_LOOPBACK))
+
+/* I8, I9 and I28 can only be changed with MCE set. */
+#define WSS_MCE_REGS	(BIT(CS4231_PLAYBK_FORMAT) | BIT(CS4231_IFACE_CTRL) | \
+			 BIT(CS4231_REC_FORMAT))
+
+static void snd_wss_irqoff_account(struct snd_wss *chip, int site, u64 start)
+{
+	u64 delta = local_clock() - start;
+
+	if (delta > chip->stats.irqoff_max_ns[site])
+		chip->stats.irqoff_max_ns[site] = delta;
+}
+
+/* Add the time since start to one of the snd_wss_stat_time counters. */
+static void snd_wss_stat_time_add(struct snd_wss_stat_time *t, u64 start)
+{
+	unsigned int us = div_u64(local_clock() - start, NSEC_PER_USEC);
+
+	t->count++;
+	t->total_us += us;
+	if (us > t->max_us)
+		t->max_us = us;
+}
 
 /*
  *  Basic I/O functions
@@ -164,6 +286,7 @@ static void snd_wss_wait_delay(struct snd_wss *chip, unsigned char delay_microse
 {
 	unsigned char i0, timeout;
 	bool is_init_set;
+	u64 start = local_clock();
 
 	i0 = wss_inb(chip, CS4231P(REGSEL));
 	is_init_set = i0 & CS4231_INIT;
@@ -175,6 +298,7 @@ static void snd_wss_wait_delay(struct snd_wss *chip, unsigned char delay_microse
 	if (is_init_set) {
 		dev_err(chip->card->dev, "snd_wss_wait - INIT is still 1. I0=0x%x\n", i0);
 	}
+	snd_wss_stat_time_add(&chip->stats.wait_delay, start);
 }
 
 static void snd_wss_wait(struct snd_wss *chip)
@@ -183,23 +307,102 @@ static void snd_wss_wait(struct snd_wss *chip)
 	snd_wss_wait_delay(chip, 100);
 }
 
-/* Functionally similar to snd_wss_out, but the waiting time between each INIT check
- * is 10 microseconds instead of 100 microseconds. I'm not sure why, but since it works
- * I stopped investigating. */
-static void snd_wss_dout(struct snd_wss *chip, unsigned char reg,
-			 unsigned char value)
+/* Bounded version of snd_wss_wait for when reg_lock is held.
+ * Returns true when INIT is cleared and the codec takes writes. */
+static bool snd_wss_init_ready(struct snd_wss *chip)
+{
+	int polls;
+
+	for (polls = WSS_INIT_SPIN_POLLS; wss_inb(chip, CS4231P(REGSEL)) & CS4231_INIT; polls--) {
+		if (!polls)
+			return false;
+		udelay(WSS_INIT_SPIN_US);
+	}
+	return true;
+}
+
+/* True when a write has to be left in the image: either INIT didn't clear in time
+ * or earlier writes are already waiting. */
+static bool snd_wss_must_defer(struct snd_wss *chip)
 {
-	/* This loop timeouts roughly after 0.0025 second. */
-	snd_wss_wait_delay(chip, 10);
-	wss_outb(chip, CS4231P(REGSEL), chip->mce_bit | reg);
-	wss_outb(chip, CS4231P(REG), value);
+	return chip->pending_regs || chip->pending_eregs || !snd_wss_init_ready(chip);
+}
+
+static void snd_wss_defer(struct snd_wss *chip, unsigned int regs, unsigned int eregs)
+{
+	chip->pending_regs |= regs;
+	chip->pending_eregs |= eregs;
+	chip->stats.deferred_writes++;
+	/* mod_, not schedule_: the work may already wait for the mixer delay
+	 * or the 100 ms retry, and these writes shouldn't wait that long. */
+	mod_delayed_work(system_wq, &chip->pending_work, 1);
+}
+
+/* Wait for INIT with interrupts on, like snd_wss_pending_work does. For the
+ * reads which can sleep, so the bounded spin of snd_wss_in doesn't run out
+ * while the codec is still coming back from a resume. */
+static int snd_wss_init_wait(struct snd_wss *chip)
+{
+	unsigned char i0;
+
+	return read_poll_timeout(wss_inb, i0, !(i0 & CS4231_INIT), 100, 25000,
+				 false, chip, CS4231P(REGSEL));
+}
+
+/* snd_wss_init_ready for the reads. A read can't be deferred, so when INIT is
+ * still set after the bounded spin, R1 reads 0x80 like it did after snd_wss_wait
+ * timed out. That's not a value the caller should trust, so say it. */
+static void snd_wss_read_ready(struct snd_wss *chip, const char *what, unsigned char reg)
+{
+	if (snd_wss_init_ready(chip))
+		return;
+	chip->stats.init_read_timeouts++;
+	dev_warn_ratelimited(chip->card->dev, "%s - INIT is still 1, reg 0x%x reads 0x80\n",
+			     what, reg);
+}
+
+/* Write the pairs on R0 and R1 one after the other. No INIT check, no barrier
+ * and chip->image is left alone; the callers below take care of that. */
+static void snd_wss_stream_out(struct snd_wss *chip,
+			       const struct snd_wss_reg_val *regs,
+			       unsigned int count)
+{
+	unsigned int i;
+
+	for (i = 0; i < count; i++) {
+		wss_outb(chip, CS4231P(REGSEL), chip->mce_bit | regs[i].reg);
+		wss_outb(chip, CS4231P(REG), regs[i].val);
+	}
+	chip->stats.reg_writes += count;
+}
+
+/* Functionally similar to snd_wss_out_batch, but the waiting time between each INIT check
+ * is 10 microseconds instead of 100 microseconds and chip->image is not updated. I'm not
+ * sure why the original snd_wss_dout waited less, but since it works I stopped investigating.
+ * Used for the calibration mute values which must never end up in chip->image. */
+static void snd_wss_dout_batch(struct snd_wss *chip,
+			       const struct snd_wss_reg_val *regs,
+			       unsigned int count)
+{
+	/* The caller already waited for INIT with interrupts on. The mute values
+	 * can't be deferred through the image, so after the bounded spin they are
+	 * written anyway like snd_wss_dout did after its 0.0025 second timeout. */
+	snd_wss_init_ready(chip);
+	snd_wss_stream_out(chip, regs, count);
 	mb();
 }
 
 /* Select an index register and write a new value to it. */
 void snd_wss_out(struct snd_wss *chip, unsigned char index_register_address, unsigned char index_register_new_value)
 {
-	snd_wss_wait(chip);
+	u64 start = local_clock();
+
+	/* Save the latest written state in chip->image. */
+	chip->image[index_register_address] = index_register_new_value;
+	if (snd_wss_must_defer(chip)) {
+		snd_wss_defer(chip, BIT(index_register_address), 0);
+		goto out;
+	}
 	/* CS4231P(REGSEL) is 0 which is R0, the Index Address Register.
 	 * This writes the value of reg on it keeping the last known value of mce_bit.
 	 * This is only useful to change IA0 to IA4 and change the values on the Index Data Register. */
@@ -209,21 +412,72 @@ void snd_wss_out(struct snd_wss *chip, unsigned char index_register_address, uns
 	 * of the WSS Codec, this register can NOT be
 	 * written and is always read 10000000 (80h) */
 	wss_outb(chip, CS4231P(REG), index_register_new_value);
-	/* Save the latest written state in chip->image. */
-	chip->image[index_register_address] = index_register_new_value;
 	/* mb() prevents loads and stores being reordered across this point */
 	mb();
+	chip->stats.reg_writes++;
+out:
+	trace_snd_wss_out(chip, index_register_address, index_register_new_value, start,
+			  chip->pending_regs & BIT(index_register_address));
+	snd_wss_irqoff_account(chip, WSS_IRQOFF_OUT, start);
 }
 EXPORT_SYMBOL(snd_wss_out);
 
+/* Write several index registers in one go.
+ * snd_wss_out() checks INIT and issues a mb() for every register. INIT only goes
+ * up while the codec initializes, is powered down or calibrates after MCE is
+ * cleared. Writing R0 and R1 doesn't do any of that, so checking INIT once before
+ * the first write is enough. The barrier and the chip->image update are done once
+ * after the last write. Same locking rules as snd_wss_out(). */
+void snd_wss_out_batch(struct snd_wss *chip,
+		       const struct snd_wss_reg_val *regs, unsigned int count)
+{
+	u64 start = local_clock();
+	unsigned int i, mask = 0;
+
+	if (!count)
+		return;
+	if (snd_wss_must_defer(chip)) {
+		for (i = 0; i < count; i++) {
+			chip->image[regs[i].reg] = regs[i].val;
+			mask |= BIT(regs[i].reg);
+		}
+		snd_wss_defer(chip, mask, 0);
+		goto out;
+	}
+	snd_wss_stream_out(chip, regs, count);
+	mb();
+	for (i = 0; i < count; i++)
+		chip->image[regs[i].reg] = regs[i].val;
+out:
+	if (trace_snd_wss_out_enabled())
+		for (i = 0; i < count; i++)
+			trace_snd_wss_out(chip, regs[i].reg, regs[i].val, start,
+					  chip->pending_regs & BIT(regs[i].reg));
+	snd_wss_irqoff_account(chip, WSS_IRQOFF_OUT_BATCH, start);
+}
+EXPORT_SYMBOL(snd_wss_out_batch);
+
 /* Read value from an index register "reg" and return it. */
 unsigned char snd_wss_in(struct snd_wss *chip, unsigned char reg)
 {
+	u64 start = local_clock();
 	unsigned char index_register_value;
-	snd_wss_wait(chip);
-	wss_outb(chip, CS4231P(REGSEL), chip->mce_bit | reg);
-	mb();
-	return wss_inb(chip, CS4231P(REG));
+	/* A write still waiting in the image is newer than what the codec has.
+	 * Reading the codec would lose it in a read-modify-write. */
+	bool deferred = (chip->pending_regs | chip->mixer_regs) & BIT(reg);
+
+	if (deferred) {
+		index_register_value = chip->image[reg];
+	} else {
+		snd_wss_read_ready(chip, "snd_wss_in", reg);
+		wss_outb(chip, CS4231P(REGSEL), chip->mce_bit | reg);
+		mb();
+		index_register_value = wss_inb(chip, CS4231P(REG));
+		chip->stats.reg_reads++;
+	}
+	trace_snd_wss_in(chip, reg, index_register_value, start, deferred);
+	snd_wss_irqoff_account(chip, WSS_IRQOFF_IN, start);
+	return index_register_value;
 }
 
 /* Make this function available to other drivers. */
@@ -324,10 +578,8 @@ void snd_cs4236_ext_out(struct snd_wss *chip,
 	 * 6. Read/Write new X register data from R1.
 	 * */
 	unsigned char i23_address = 0x17;
-	unsigned char xa3_xa0 = extended_register_address & 0xf0;
-	unsigned char xa4 = extended_register_address & 0x04;
-	unsigned char xrae = extended_register_address & 0x08;
-	unsigned char xa4_xa0 = xa4 << 2 | xa3_xa0 >> 4;
+	/* The CS4236_* names are CS4236_I23VAL() values with XA3-XA0 in D7-D4,
+	 * XRAE in D3 and XA4 in D2, so extended_register_address goes to I23 as is. */
 	/* I'm wondering what happens to TRD... TRD can change and is documented as:
 	 * Transfer Request Disable: This bit,
 	 * when set, causes DMA transfers to
@@ -335,30 +587,247 @@ void snd_cs4236_ext_out(struct snd_wss *chip,
 	 * Register (R2) is set. Independent for
 	 * playback and capture interrupts.
 	 * For now, sound works on my 560z so I didn't investigate further. */
+	u64 start = local_clock();
+
+	chip->eimage[CS4236_REG(extended_register_address)] = new_value;
+	if (snd_wss_must_defer(chip)) {
+		snd_wss_defer(chip, 0, BIT(CS4236_REG(extended_register_address)));
+		goto out;
+	}
 	wss_outb(chip, CS4231P(REGSEL), chip->mce_bit | i23_address);
 	wss_outb(chip, CS4231P(REG),
 			extended_register_address | (chip->image[CS4236_EXT_REG] & 0x01));
 	wss_outb(chip, CS4231P(REG), new_value);
-	chip->eimage[CS4236_REG(extended_register_address)] = new_value;
+	chip->stats.ereg_writes++;
+out:
+	trace_snd_cs4236_ext_out(chip, extended_register_address, new_value, start,
+				 chip->pending_eregs & BIT(CS4236_REG(extended_register_address)));
+	snd_wss_irqoff_account(chip, WSS_IRQOFF_EXT_OUT, start);
 }
 EXPORT_SYMBOL(snd_cs4236_ext_out);
 
+/* The 3 writes of steps 4 to 6 for every pair, no INIT check, no barrier. */
+static void snd_cs4236_ext_stream_out(struct snd_wss *chip,
+				      const struct snd_wss_reg_val *regs,
+				      unsigned int count)
+{
+	unsigned char acf = chip->image[CS4236_EXT_REG] & 0x01;
+	unsigned int i;
+
+	for (i = 0; i < count; i++) {
+		wss_outb(chip, CS4231P(REGSEL), chip->mce_bit | CS4236_EXT_REG);
+		wss_outb(chip, CS4231P(REG), regs[i].reg | acf);
+		wss_outb(chip, CS4231P(REG), regs[i].val);
+	}
+	chip->stats.ereg_writes += count;
+}
+
+/* Write several extended registers in one go.
+ * Writing R0 clears XRAE, so every X register still needs the 3 writes of
+ * steps 4 to 6 above, but INIT is checked once before the first one and the
+ * barrier and the chip->eimage update are done once after the last one. */
+void snd_cs4236_ext_out_batch(struct snd_wss *chip,
+			      const struct snd_wss_reg_val *regs, unsigned int count)
+{
+	u64 start = local_clock();
+	unsigned int i, mask = 0;
+
+	if (!count)
+		return;
+	if (snd_wss_must_defer(chip)) {
+		for (i = 0; i < count; i++) {
+			chip->eimage[CS4236_REG(regs[i].reg)] = regs[i].val;
+			mask |= BIT(CS4236_REG(regs[i].reg));
+		}
+		snd_wss_defer(chip, 0, mask);
+		goto out;
+	}
+	snd_cs4236_ext_stream_out(chip, regs, count);
+	mb();
+	for (i = 0; i < count; i++)
+		chip->eimage[CS4236_REG(regs[i].reg)] = regs[i].val;
+out:
+	if (trace_snd_cs4236_ext_out_enabled())
+		for (i = 0; i < count; i++)
+			trace_snd_cs4236_ext_out(chip, regs[i].reg, regs[i].val, start,
+						 chip->pending_eregs & BIT(CS4236_REG(regs[i].reg)));
+	snd_wss_irqoff_account(chip, WSS_IRQOFF_EXT_OUT_BATCH, start);
+}
+EXPORT_SYMBOL(snd_cs4236_ext_out_batch);
+
 /* Read the extended register. */
 unsigned char snd_cs4236_ext_in(struct snd_wss *chip, unsigned char extended_register_address)
 {
 	unsigned char res;
 	unsigned char i23_address = 0x17;
-	unsigned char xa3_xa0 = extended_register_address & 0xf0;
-	unsigned char xa4 = extended_register_address & 0x04;
-	unsigned char xrae = extended_register_address & 0x08;
-	unsigned char xa4_xa0 = xa4 << 2 | xa3_xa0 >> 4;
-	wss_outb(chip, CS4231P(REGSEL), chip->mce_bit | i23_address);
-	wss_outb(chip, CS4231P(REG),
-			extended_register_address | (chip->image[CS4236_EXT_REG] & 0x01));
-	return wss_inb(chip, CS4231P(REG));
+	/* The CS4236_* names are CS4236_I23VAL() values with XA3-XA0 in D7-D4,
+	 * XRAE in D3 and XA4 in D2, so extended_register_address goes to I23 as is. */
+	u64 start = local_clock();
+	/* Same as snd_wss_in for the X registers in chip->eimage. */
+	bool deferred = (chip->pending_eregs | chip->mixer_eregs) &
+			BIT(CS4236_REG(extended_register_address));
+
+	if (deferred) {
+		res = chip->eimage[CS4236_REG(extended_register_address)];
+	} else {
+		snd_wss_read_ready(chip, "snd_cs4236_ext_in", extended_register_address);
+		wss_outb(chip, CS4231P(REGSEL), chip->mce_bit | i23_address);
+		wss_outb(chip, CS4231P(REG),
+				extended_register_address | (chip->image[CS4236_EXT_REG] & 0x01));
+		res = wss_inb(chip, CS4231P(REG));
+		chip->stats.ereg_reads++;
+	}
+	trace_snd_cs4236_ext_in(chip, extended_register_address, res, start, deferred);
+	snd_wss_irqoff_account(chip, WSS_IRQOFF_EXT_IN, start);
+	return res;
 }
 EXPORT_SYMBOL(snd_cs4236_ext_in);
 
+/* After RESDRV or a power loss, I12 is back to MODE 1 (CMS1,0 = 00).
+ * The driver always runs the codec in MODE 3, so this tells if the
+ * codec kept its registers or if it has to be programmed again.
+ * Right after a resume INIT can stay set for a while and I12 would read
+ * 0x80, which looks like MODE 1, so INIT is waited for the full 25 ms like
+ * snd_wss_wait did. Sleeps: call it without reg_lock. */
+bool snd_wss_codec_was_reset(struct snd_wss *chip)
+{
+	unsigned char i12;
+
+	if (snd_wss_init_wait(chip))
+		dev_err(chip->card->dev, "snd_wss_codec_was_reset - INIT is still 1\n");
+	scoped_guard(spinlock_irqsave, &chip->reg_lock)
+		i12 = snd_wss_in(chip, CS4231_MISC_INFO);
+	/* 0x60 are the CMS1,0 bits */
+	return (i12 & 0x60) == 0;
+}
+EXPORT_SYMBOL(snd_wss_codec_was_reset);
+
+/* Fill regs with the chip->image registers to write back to the codec, ready for
+ * snd_wss_out_batch(). I12 comes first so MODE 3 is set before I16-I31 and the
+ * X registers are written, unless it's in skip too. Volatile registers and the
+ * ones in the skip bit mask are left out. When changed_only is set, the registers still at their reset value
+ * are left out too; that's what is needed after snd_wss_codec_was_reset().
+ * regs must have room for 32 entries. Returns the number of entries filled. */
+unsigned int snd_wss_image_regs(struct snd_wss *chip, struct snd_wss_reg_val *regs,
+				unsigned int skip, bool changed_only)
+{
+	unsigned int count = 0;
+	int reg;
+
+	skip |= WSS_VOLATILE_REGS;
+	if (!(skip & BIT(CS4231_MISC_INFO))) {
+		regs[count].reg = CS4231_MISC_INFO;
+		regs[count++].val = chip->image[CS4231_MISC_INFO];
+	}
+	for (reg = 0; reg < 32; reg++) {
+		if (reg == CS4231_MISC_INFO || (skip & BIT(reg)))
+			continue;
+		if (changed_only && !(WSS_NO_DEFAULT_REGS & BIT(reg)) &&
+		    chip->image[reg] == snd_wss_reset_image[reg])
+			continue;
+		regs[count].reg = reg;
+		regs[count++].val = chip->image[reg];
+	}
+	return count;
+}
+EXPORT_SYMBOL(snd_wss_image_regs);
+
+/* Write the registers which were left in the image while INIT was set.
+ * Runs in process context, so INIT is waited for with interrupts on. */
+static void snd_wss_pending_work(struct work_struct *work)
+{
+	struct snd_wss *chip = container_of(to_delayed_work(work),
+					    struct snd_wss, pending_work);
+	struct snd_wss_reg_val regs[32], eregs[32];
+	unsigned int count = 0, ecount = 0;
+	unsigned char i0;
+	bool mce, flushed = false;
+	int reg;
+
+	guard(mutex)(&chip->mce_mutex);
+	if (read_poll_timeout(wss_inb, i0, !(i0 & CS4231_INIT), 100, 25000,
+			      false, chip, CS4231P(REGSEL))) {
+		dev_err(chip->card->dev, "snd_wss_pending_work - INIT is still 1. I0=0x%x\n", i0);
+		schedule_delayed_work(&chip->pending_work, msecs_to_jiffies(100));
+		return;
+	}
+	/* Without MCE a deferred I8/I9/I28 value could be only partly taken
+	 * (e.g. the fast format change sequence of cs4236_lib), so open an
+	 * MCE window around them. */
+	mce = ((chip->pending_regs | chip->mixer_regs) & WSS_MCE_REGS) &&
+	      !(chip->mce_bit & CS4231_MCE);
+	if (mce)
+		snd_wss_mce_up(chip);
+	scoped_guard(spinlock_irqsave, &chip->reg_lock) {
+		if (!snd_wss_init_ready(chip))
+			break;
+		for (reg = 0; reg < 32; reg++) {
+			if ((chip->pending_regs | chip->mixer_regs) & BIT(reg)) {
+				regs[count].reg = reg;
+				regs[count++].val = chip->image[reg];
+			}
+			if ((chip->pending_eregs | chip->mixer_eregs) & BIT(reg)) {
+				eregs[ecount].reg = CS4236_I23VAL(reg);
+				eregs[ecount++].val = chip->eimage[reg];
+			}
+		}
+		if (chip->pending_regs || chip->pending_eregs)
+			chip->stats.deferred_flushes++;
+		chip->stats.mixer_flushed += hweight32(chip->mixer_regs) +
+					     hweight32(chip->mixer_eregs);
+		chip->pending_regs = 0;
+		chip->pending_eregs = 0;
+		chip->mixer_regs = 0;
+		chip->mixer_eregs = 0;
+		snd_wss_stream_out(chip, regs, count);
+		snd_cs4236_ext_stream_out(chip, eregs, ecount);
+		mb();
+		flushed = true;
+	}
+	if (mce)
+		snd_wss_mce_down(chip);
+	if (!flushed)
+		schedule_delayed_work(&chip->pending_work, 1);
+}
+
+/* Mixer writes. The value goes in the image and snd_wss_pending_work writes it
+ * WSS_MIXER_DELAY_MS later. Dragging a slider in alsamixer or an alsactl restore
+ * puts hundreds of values; only the last one of each register reaches the codec.
+ * Unlike the writes deferred because of INIT, these don't hold back the other
+ * writes: a direct write of another register can go first. Called with
+ * reg_lock held. */
+#define WSS_MIXER_DELAY_MS	20
+
+void snd_wss_out_mixer(struct snd_wss *chip, unsigned char reg, unsigned char val)
+{
+	chip->stats.mixer_writes++;
+	if (chip->image[reg] == val)
+		return;
+	chip->image[reg] = val;
+	chip->mixer_regs |= BIT(reg);
+	schedule_delayed_work(&chip->pending_work, msecs_to_jiffies(WSS_MIXER_DELAY_MS));
+}
+EXPORT_SYMBOL(snd_wss_out_mixer);
+
+void snd_cs4236_ext_out_mixer(struct snd_wss *chip, unsigned char reg, unsigned char val)
+{
+	chip->stats.mixer_writes++;
+	if (chip->eimage[CS4236_REG(reg)] == val)
+		return;
+	chip->eimage[CS4236_REG(reg)] = val;
+	chip->mixer_eregs |= BIT(CS4236_REG(reg));
+	schedule_delayed_work(&chip->pending_work, msecs_to_jiffies(WSS_MIXER_DELAY_MS));
+}
+EXPORT_SYMBOL(snd_cs4236_ext_out_mixer);
+
+static void snd_wss_cancel_pending(void *data)
+{
+	struct snd_wss *chip = data;
+
+	flush_work(&chip->calib_work);
+	cancel_delayed_work_sync(&chip->pending_work);
+}
+
 
 /*
  *  CS4231 detection / MCE routines
@@ -367,18 +836,54 @@ EXPORT_SYMBOL(snd_cs4236_ext_in);
 /* This looks like it is doing 2 things:
  * 1. busy wait
  * 2. "cleanup sequence" which could mean waiting for the register to have good values again? */
+/* Sort a snd_wss_busy_wait wait into the buckets of stats.busy_wait_hist. */
+static void snd_wss_busy_wait_account(struct snd_wss *chip, u64 waited_ns, bool timed_out)
+{
+	static const unsigned int bucket_us[WSS_BUSY_WAIT_BUCKETS - 1] = {
+		0, 1000, 10000, 100000
+	};
+	unsigned int us = div_u64(waited_ns, NSEC_PER_USEC);
+	int bucket = 0;
+
+	while (bucket < WSS_BUSY_WAIT_BUCKETS - 1 && us > bucket_us[bucket])
+		bucket++;
+	chip->stats.busy_wait_hist[bucket]++;
+	chip->stats.busy_wait_total_us += us;
+	if (us > chip->stats.busy_wait_max_us)
+		chip->stats.busy_wait_max_us = us;
+	if (timed_out)
+		chip->stats.busy_wait_timeouts++;
+}
+
+/* Wait up to 250 ms for INIT to clear. This used to be 25000 x udelay(10), so
+ * up to 250 ms of CPU taken from whatever else runs on the 560z (mpg123 feeding
+ * this same card for example) every time snd_wss_mce_down is called. Sleeping
+ * between the reads keeps the same timeout without burning the CPU.
+ * Must be called from process context without reg_lock held. */
 static void snd_wss_busy_wait(struct snd_wss *chip)
 {
-	int timeout;
+	unsigned char i0;
+	u64 start, waited;
+	int timeout, err;
 
+	might_sleep();
 	/* huh.. looks like this sequence is proper for CS4231A chip (GUS MAX) */
 	for (timeout = 5; timeout > 0; timeout--)
 		wss_inb(chip, CS4231P(REGSEL));
 	/* end of cleanup sequence */
-	for (timeout = 25000;
-	     timeout > 0 && (wss_inb(chip, CS4231P(REGSEL)) & CS4231_INIT);
-	     timeout--)
-		udelay(10);
+	start = local_clock();
+	err = read_poll_timeout(wss_inb, i0, !(i0 & CS4231_INIT), 100, 250000,
+				false, chip, CS4231P(REGSEL));
+	waited = local_clock() - start;
+	snd_wss_busy_wait_account(chip, waited, err);
+	trace_snd_wss_busy_wait(chip, waited, err);
+}
+
+/* Sleep until a calibration started by snd_wss_mce_down_async is over.
+ * Returns right away when none is running. */
+static void snd_wss_calib_wait(struct snd_wss *chip)
+{
+	wait_for_completion(&chip->calib_done);
 }
 
 /* Mode Change Enable Up: required before changing indirect registers:
@@ -388,14 +893,20 @@ void snd_wss_mce_up(struct snd_wss *chip)
 {
 	unsigned char index_address_register, cannot_respond, set_mce;
 	bool is_mce_set;
+	u64 start;
 
+	/* MCE can't go up again while the codec still calibrates. */
+	snd_wss_calib_wait(chip);
 	snd_wss_wait(chip);
 	guard(spinlock_irqsave)(&chip->reg_lock);
+	start = local_clock();
+	chip->stats.mce_cycles++;
 	chip->mce_bit |= CS4231_MCE;
 	index_address_register = wss_inb(chip, CS4231P(REGSEL));
 	set_mce = CS4231_MCE | (index_address_register & WSS_IA01234_MASK);
 	is_mce_set = (index_address_register & CS4231_MCE) != 0;
 	cannot_respond = index_address_register & CS4231_INIT;
+	trace_snd_wss_mce_up(chip, index_address_register);
 	if (!is_mce_set && !cannot_respond)
 		/* chip->mce was originally an int, which is strange bceause its name has "bit" so it should
 		 * be a single bit. Since we use it to prepare the value to set on the indirect_address_register
@@ -404,29 +915,39 @@ void snd_wss_mce_up(struct snd_wss *chip)
 		 * value... Since TRD controls DMA transfers, it looks like it could impact playback and capture.
 		 * It works for now on my 560z so I haven't investigated further. */
 		wss_outb(chip, CS4231P(REGSEL), chip->mce_bit | set_mce);
+	snd_wss_irqoff_account(chip, WSS_IRQOFF_MCE, start);
 }
 EXPORT_SYMBOL(snd_wss_mce_up);
 
-/* Mode Change Enable Down: locks the indirect registers.  */
-void snd_wss_mce_down(struct snd_wss *chip)
+/* First half of snd_wss_mce_down: clear MCE. Returns true when MCE was set,
+ * so the codec may now be calibrating. */
+static bool snd_wss_mce_down_start(struct snd_wss *chip)
 {
-	unsigned long end_time;
-	unsigned char index_address_register, i0, i11;
-	bool is_mce_set, is_aci_cleared=true, is_init_cleared=true;
+	unsigned char index_address_register;
 
 	snd_wss_busy_wait(chip);
 
 	scoped_guard(spinlock_irqsave, &chip->reg_lock) {
+		u64 start = local_clock();
+
 		chip->mce_bit &= ~CS4231_MCE;
 		index_address_register = wss_inb(chip, CS4231P(REGSEL));
 		/* Same as for snd_wss_mce_up; what's happening with the TRD bit here? */
 		wss_outb(chip, CS4231P(REGSEL), chip->mce_bit | (index_address_register & WSS_IA01234_MASK));
+		snd_wss_irqoff_account(chip, WSS_IRQOFF_MCE, start);
 	}
-	is_mce_set = (index_address_register & CS4231_MCE) != 0;
 	/* There was an hardware check here before. I removed it because snd_wss_mce_up doesn't have that check.
 	 * So if we can set the mce up, I think we should be able to set it down. */
-	if (!is_mce_set)
-		return;
+	return (index_address_register & CS4231_MCE) != 0;
+}
+
+/* Second half of snd_wss_mce_down: wait for the calibration to be over. */
+static void snd_wss_mce_down_finish(struct snd_wss *chip)
+{
+	unsigned long end_time;
+	unsigned char i0, i11;
+	bool is_aci_cleared=true, is_init_cleared=true;
+	u64 start = local_clock();
 
 	/*
 	 * Wait for (possible -- during init auto-calibration may not be set)
@@ -467,14 +988,50 @@ void snd_wss_mce_down(struct snd_wss *chip)
 		i0 = wss_inb(chip, CS4231P(REGSEL));
 	}
 
-	if (!is_init_cleared || !is_aci_cleared) {
+	trace_snd_wss_mce_down(chip, start, i0, i11, !is_aci_cleared, !is_init_cleared);
+	/* A format change can only be skipped after a calibration which went fine. */
+	chip->calibrated = is_init_cleared && is_aci_cleared;
+	snd_wss_stat_time_add(&chip->stats.calib, start);
+	if (!chip->calibrated) {
+		chip->stats.calib_timeouts++;
 		dev_err(chip->card->dev,
 				"is_init_cleared=%d,is_aci_cleared=%d,I0=0x%x,I11=0x%x\n",
 				is_init_cleared, is_aci_cleared, i0, i11);
 	}
+	/* Calibration is over; write what was deferred while it ran. */
+	if (chip->pending_regs || chip->pending_eregs)
+		mod_delayed_work(system_wq, &chip->pending_work, 0);
+}
+
+/* Mode Change Enable Down: locks the indirect registers.  */
+void snd_wss_mce_down(struct snd_wss *chip)
+{
+	if (snd_wss_mce_down_start(chip))
+		snd_wss_mce_down_finish(chip);
 }
 EXPORT_SYMBOL(snd_wss_mce_down);
 
+static void snd_wss_calib_work(struct work_struct *work)
+{
+	struct snd_wss *chip = container_of(work, struct snd_wss, calib_work);
+
+	snd_wss_mce_down_finish(chip);
+	complete_all(&chip->calib_done);
+}
+
+/* Same as snd_wss_mce_down but the wait for the calibration is done by
+ * snd_wss_calib_work. hw_params returns right away and the application can
+ * fill its first periods while the codec calibrates.
+ * snd_wss_calib_wait is what waits for it to be over. */
+static void snd_wss_mce_down_async(struct snd_wss *chip)
+{
+	if (!snd_wss_mce_down_start(chip))
+		return;
+	reinit_completion(&chip->calib_done);
+	schedule_work(&chip->calib_work);
+}
+
+
 /* Get the count of reads for the DMA so that the DACs will have the right data for playback. */
 static unsigned int snd_wss_get_count(unsigned char format, unsigned int size)
 {
@@ -509,10 +1066,54 @@ static unsigned int snd_wss_get_count(unsigned char format, unsigned int size)
 	return size;
 }
 
+/* True when the capture in what is IMA ADPCM. Only the CS4236 and later have
+ * ACF in I23. */
+static bool snd_wss_adpcm_capture(struct snd_wss *chip, unsigned int what)
+{
+	return (what & CS4231_RECORD_ENABLE) &&
+	       (snd_wss_hardware(chip) & WSS_HW_CS4236B_MASK) &&
+	       (chip->image[CS4231_REC_FORMAT] & 0xe0) == CS4231_ADPCM_16;
+}
+
+/* Keep the DMA position where the pause stopped it; the pointer callbacks
+ * return it until the stream is released. */
+static void snd_wss_pause_pointers(struct snd_wss *chip, unsigned int what)
+{
+	if (what & CS4231_PLAYBACK_ENABLE)
+		chip->p_ptr = snd_dma_pointer(chip->dma1, chip->p_dma_size);
+	if (what & CS4231_RECORD_ENABLE)
+		chip->c_ptr = snd_dma_pointer(chip->dma2, chip->c_dma_size);
+	chip->stats.pointer_dma_reads += hweight8(what & (CS4231_PLAYBACK_ENABLE |
+							  CS4231_RECORD_ENABLE));
+	chip->paused |= what;
+}
+
+static void snd_wss_resume_dma(struct snd_wss *chip, unsigned int what)
+{
+	if (what & CS4231_PLAYBACK_ENABLE)
+		snd_dma_program(chip->dma1, chip->playback_substream->runtime->dma_addr,
+				chip->p_dma_size, DMA_MODE_WRITE | DMA_AUTOINIT);
+	if (what & CS4231_RECORD_ENABLE)
+		snd_dma_program(chip->dma2, chip->capture_substream->runtime->dma_addr,
+				chip->c_dma_size, DMA_MODE_READ | DMA_AUTOINIT);
+}
+
+/* The CS4237B needs nothing besides I9, so in CS4237B only builds there's no
+ * hook to call. */
+static inline void snd_wss_trigger_hook(struct snd_wss *chip, unsigned int what,
+					int start)
+{
+#ifndef CONFIG_SND_WSS_CS4237B_ONLY
+	if (chip->trigger)
+		chip->trigger(chip, what, start);
+#endif
+}
+
 static int snd_wss_trigger(struct snd_pcm_substream *substream,
 			   int cmd)
 {
 	struct snd_wss *chip = snd_pcm_substream_chip(substream);
+	u64 start = local_clock();
 	int result = 0;
 	unsigned int what;
 	struct snd_pcm_substream *s;
@@ -521,9 +1122,11 @@ static int snd_wss_trigger(struct snd_pcm_substream *substream,
 	switch (cmd) {
 	case SNDRV_PCM_TRIGGER_START:
 	case SNDRV_PCM_TRIGGER_RESUME:
+	case SNDRV_PCM_TRIGGER_PAUSE_RELEASE:
 		do_start = 1; break;
 	case SNDRV_PCM_TRIGGER_STOP:
 	case SNDRV_PCM_TRIGGER_SUSPEND:
+	case SNDRV_PCM_TRIGGER_PAUSE_PUSH:
 		do_start = 0; break;
 	default:
 		return -EINVAL;
@@ -540,16 +1143,64 @@ static int snd_wss_trigger(struct snd_pcm_substream *substream,
 		}
 	}
 	guard(spinlock)(&chip->reg_lock);
+	/* Pause only clears PEN/CEN in I9, which doesn't need MCE. The DMA stays
+	 * programmed, so release is a single write of I9 and no prepare. */
+	if (cmd == SNDRV_PCM_TRIGGER_PAUSE_PUSH) {
+		snd_wss_pause_pointers(chip, what);
+		/* ACF freezes the ADPCM accumulator and step size, so the
+		 * capture picks up where it was. */
+		if (snd_wss_adpcm_capture(chip, what))
+			snd_wss_out(chip, CS4236_EXT_REG,
+				    chip->image[CS4236_EXT_REG] | 0x01);
+	} else if (cmd == SNDRV_PCM_TRIGGER_PAUSE_RELEASE) {
+		/* Paused across a suspend: ALSA doesn't trigger RESUME for it. */
+		if (chip->dma_lost & what) {
+			snd_wss_resume_dma(chip, chip->dma_lost & what);
+			if (chip->dma_lost & what & CS4231_PLAYBACK_ENABLE)
+				chip->p_ptr = 0;
+			if (chip->dma_lost & what & CS4231_RECORD_ENABLE)
+				chip->c_ptr = 0;
+			chip->dma_lost &= ~what;
+		}
+		if (what & CS4231_PLAYBACK_ENABLE)
+			chip->p_ptr_time = local_clock();
+		if (snd_wss_adpcm_capture(chip, what))
+			snd_wss_out(chip, CS4236_EXT_REG,
+				    chip->image[CS4236_EXT_REG] & ~0x01);
+	} else if (do_start) {
+		/* The 8237 lost its programming while suspended. The image already
+		 * has everything else back, snd_wss_resume or snd_cs4236_resume wrote
+		 * it. The DMA restarts at the start of the buffer; the pointer then
+		 * looks like a wrap to ALSA and at most one buffer is skipped. */
+		if (cmd == SNDRV_PCM_TRIGGER_RESUME)
+			snd_wss_resume_dma(chip, what);
+		/* The DMA was programmed from the start of the buffer in prepare. */
+		if (what & CS4231_PLAYBACK_ENABLE) {
+			chip->p_ptr = 0;
+			chip->p_ptr_time = local_clock();
+		}
+		if (what & CS4231_RECORD_ENABLE)
+			chip->c_ptr = 0;
+	} else {
+		/* Stopped while paused: the next start must not find ACF set. */
+		if ((chip->paused & what & CS4231_RECORD_ENABLE) &&
+		    (chip->image[CS4236_EXT_REG] & 0x01))
+			snd_wss_out(chip, CS4236_EXT_REG,
+				    chip->image[CS4236_EXT_REG] & ~0x01);
+		chip->paused &= ~what;
+		chip->dma_lost &= ~what;
+	}
 	if (do_start) {
+		chip->paused &= ~what;
 		chip->image[CS4231_IFACE_CTRL] |= what;
-		if (chip->trigger)
-			chip->trigger(chip, what, 1);
+		snd_wss_trigger_hook(chip, what, 1);
 	} else {
 		chip->image[CS4231_IFACE_CTRL] &= ~what;
-		if (chip->trigger)
-			chip->trigger(chip, what, 0);
+		snd_wss_trigger_hook(chip, what, 0);
 	}
 	snd_wss_out(chip, CS4231_IFACE_CTRL, chip->image[CS4231_IFACE_CTRL]);
+	trace_snd_wss_trigger(chip, cmd, what);
+	snd_wss_irqoff_account(chip, WSS_IRQOFF_TRIGGER, start);
 	return result;
 }
 
@@ -589,39 +1240,31 @@ static unsigned char snd_wss_get_format(struct snd_wss *chip,
 
 static void snd_wss_calibrate_mute(struct snd_wss *chip, int mute)
 {
+	const unsigned char *image = chip->image;
+	unsigned char i0;
 
 	mute = mute ? 0x80 : 0;
+	/* Wait for INIT here with interrupts on instead of in snd_wss_dout_batch.
+	 * Same 0.0025 second timeout; a timeout is handled there. */
+	read_poll_timeout(wss_inb, i0, !(i0 & CS4231_INIT), 10, 2500,
+			  false, chip, CS4231P(REGSEL));
 	guard(spinlock_irqsave)(&chip->reg_lock);
 	if (chip->calibrate_mute == mute)
 		return;
-	if (!mute) {
-		snd_wss_dout(chip, CS4231_LEFT_INPUT,
-			     chip->image[CS4231_LEFT_INPUT]);
-		snd_wss_dout(chip, CS4231_RIGHT_INPUT,
-			     chip->image[CS4231_RIGHT_INPUT]);
-		snd_wss_dout(chip, CS4231_LOOPBACK,
-			     chip->image[CS4231_LOOPBACK]);
-	} else {
-		snd_wss_dout(chip, CS4231_LEFT_INPUT,
-			     0);
-		snd_wss_dout(chip, CS4231_RIGHT_INPUT,
-			     0);
-		snd_wss_dout(chip, CS4231_LOOPBACK,
-			     0xfd);
-	}
-
-	snd_wss_dout(chip, CS4231_AUX1_LEFT_INPUT,
-		     mute | chip->image[CS4231_AUX1_LEFT_INPUT]);
-	snd_wss_dout(chip, CS4231_AUX1_RIGHT_INPUT,
-		     mute | chip->image[CS4231_AUX1_RIGHT_INPUT]);
-	snd_wss_dout(chip, CS4231_AUX2_LEFT_INPUT,
-		     mute | chip->image[CS4231_AUX2_LEFT_INPUT]);
-	snd_wss_dout(chip, CS4231_AUX2_RIGHT_INPUT,
-		     mute | chip->image[CS4231_AUX2_RIGHT_INPUT]);
-	snd_wss_dout(chip, CS4231_LEFT_OUTPUT,
-		     mute | chip->image[CS4231_LEFT_OUTPUT]);
-	snd_wss_dout(chip, CS4231_RIGHT_OUTPUT,
-		     mute | chip->image[CS4231_RIGHT_OUTPUT]);
+
+	const struct snd_wss_reg_val regs[] = {
+		{ CS4231_LEFT_INPUT,	   mute ? 0 : image[CS4231_LEFT_INPUT] },
+		{ CS4231_RIGHT_INPUT,	   mute ? 0 : image[CS4231_RIGHT_INPUT] },
+		{ CS4231_LOOPBACK,	   mute ? 0xfd : image[CS4231_LOOPBACK] },
+		{ CS4231_AUX1_LEFT_INPUT,  mute | image[CS4231_AUX1_LEFT_INPUT] },
+		{ CS4231_AUX1_RIGHT_INPUT, mute | image[CS4231_AUX1_RIGHT_INPUT] },
+		{ CS4231_AUX2_LEFT_INPUT,  mute | image[CS4231_AUX2_LEFT_INPUT] },
+		{ CS4231_AUX2_RIGHT_INPUT, mute | image[CS4231_AUX2_RIGHT_INPUT] },
+		{ CS4231_LEFT_OUTPUT,	   mute | image[CS4231_LEFT_OUTPUT] },
+		{ CS4231_RIGHT_OUTPUT,	   mute | image[CS4231_RIGHT_OUTPUT] },
+	};
+
+	snd_wss_dout_batch(chip, regs, ARRAY_SIZE(regs));
 	/* simplfied code since hardware is WSS_HW_CS4237B */
 	chip->calibrate_mute = mute;
 }
@@ -650,12 +1293,17 @@ static void snd_wss_playback_format(struct snd_wss *chip,
 	 * I removed code which was checking for other versions than the CS4237B. */
 
 	guard(mutex)(&chip->mce_mutex);
+	/* A playlist of same rate tracks reopens the PCM with the same format every
+	 * time. chip->image is what's in the codec, so there's nothing to write and
+	 * no need to calibrate again. */
+	if (chip->calibrated && chip->image[CS4231_PLAYBK_FORMAT] == pdfr)
+		return;
 	snd_wss_mce_up(chip);
 	scoped_guard(spinlock_irqsave, &chip->reg_lock) {
 		chip->image[CS4231_PLAYBK_FORMAT] = pdfr;
 		snd_wss_out(chip, CS4231_PLAYBK_FORMAT, pdfr);
 	}
-	snd_wss_mce_down(chip);
+	snd_wss_mce_down_async(chip);
 }
 
 /* set the capture format on 
@@ -676,6 +1324,12 @@ static void snd_wss_capture_format(struct snd_wss *chip,
 	unsigned long flags;
 
 	guard(mutex)(&chip->mce_mutex);
+	/* Same as for snd_wss_playback_format. When playback is off, the sample rate
+	 * of I8 below must also match already. */
+	if (chip->calibrated && chip->image[CS4231_REC_FORMAT] == cdfr &&
+	    ((chip->image[CS4231_IFACE_CTRL] & CS4231_PLAYBACK_ENABLE) ||
+	     (chip->image[CS4231_PLAYBK_FORMAT] & 0x0f) == (cdfr & 0x0f)))
+		return;
 	snd_wss_mce_up(chip);
 	spin_lock_irqsave(&chip->reg_lock, flags);
 	/* TODO tres etrange. Je pense que ce if ne devrait pas s'appliquer. Peut-etre le garder et mettre en dbg_err 
@@ -689,16 +1343,17 @@ static void snd_wss_capture_format(struct snd_wss *chip,
 		snd_wss_mce_up(chip);
 		spin_lock_irqsave(&chip->reg_lock, flags);
 	}
-	/* TODO etrange qu'on ne sauvegarde pas le cdfr and chip->image[CS4231_REC_FORMAT].
-	 * aussi, est-ce qu'on doit faire quelque chose avec chip->image[CS4231_ALT_FEATURE_1] &= 0x20 ...
+	/* snd_wss_out keeps cdfr in chip->image[CS4231_REC_FORMAT]; resume writes it back from there.
+	 * TODO est-ce qu'on doit faire quelque chose avec chip->image[CS4231_ALT_FEATURE_1] &= 0x20 ...
 	 * Le son fonctionne sur mon 560z, je n,ai pas poursuivi mes recherches. */
 	/* chip->hardware is WSS_HW_CS4237B which is 0x0402 
 	 * WSS_HW_AD1848_MASK is 0x0800 so I can remove the if and keep the else. */
 	snd_wss_out(chip, CS4231_REC_FORMAT, cdfr);
 	spin_unlock_irqrestore(&chip->reg_lock, flags);
-	snd_wss_mce_down(chip);
+	snd_wss_mce_down_async(chip);
 }
 
+#ifdef CONFIG_SND_WSS_TIMER
 /*
  *  Timer interface
  */
@@ -706,7 +1361,7 @@ static void snd_wss_capture_format(struct snd_wss *chip,
 static unsigned long snd_wss_timer_resolution(struct snd_timer *timer)
 {
 	struct snd_wss *chip = snd_timer_chip(timer);
-	if (chip->hardware & WSS_HW_CS4236B_MASK)
+	if (snd_wss_hardware(chip) & WSS_HW_CS4236B_MASK)
 		return 14467;
 	else
 		return chip->image[CS4231_PLAYBK_FORMAT] & 1 ? 9969 : 9920;
@@ -745,11 +1400,24 @@ static int snd_wss_timer_stop(struct snd_timer *timer)
 		    chip->image[CS4231_ALT_FEATURE_1]);
 	return 0;
 }
+#endif /* CONFIG_SND_WSS_TIMER */
+
+/* Program the codec from chip->image with a single auto-calibration.
+ * This used to be five MCE up/down pairs, each one with a msleep(1) which is
+ * 2 jiffies with HZ=300, on top of the MCE cycle and the mdelay(2) at the end
+ * of snd_wss_probe. The codec auto-calibrated 3 times.
+ * Now everything goes in one MCE window with ACAL set and calibrates once when
+ * MCE goes down. ACAL is then cleared so later format changes don't calibrate,
+ * which needs one more MCE window but no calibration.
+ * When the codec comes straight from reset, the registers still at their
+ * datasheet reset values are not written. The mixer registers are left to
+ * snd_wss_calibrate_mute which writes them from the image when unmuting. */
+static void snd_wss_init(struct snd_wss *chip, bool was_reset)
+{
+	struct snd_wss_reg_val regs[32];
+	unsigned int count;
 
-static void snd_wss_init(struct snd_wss *chip)
-{
 	snd_wss_calibrate_mute(chip, 1);
-	snd_wss_mce_down(chip);
 
 	snd_wss_mce_up(chip);
 	scoped_guard(spinlock_irqsave, &chip->reg_lock) {
@@ -759,7 +1427,8 @@ static void snd_wss_init(struct snd_wss *chip)
 						    CS4231_RECORD_PIO |
 						    CS4231_CALIB_MODE);
 		chip->image[CS4231_IFACE_CTRL] |= CS4231_AUTOCALIB;
-		snd_wss_out(chip, CS4231_IFACE_CTRL, chip->image[CS4231_IFACE_CTRL]);
+		count = snd_wss_image_regs(chip, regs, WSS_MUTE_REGS, was_reset);
+		snd_wss_out_batch(chip, regs, count);
 	}
 	snd_wss_mce_down(chip);
 
@@ -767,30 +1436,9 @@ static void snd_wss_init(struct snd_wss *chip)
 	scoped_guard(spinlock_irqsave, &chip->reg_lock) {
 		chip->image[CS4231_IFACE_CTRL] &= ~CS4231_AUTOCALIB;
 		snd_wss_out(chip, CS4231_IFACE_CTRL, chip->image[CS4231_IFACE_CTRL]);
-		snd_wss_out(chip,
-			    CS4231_ALT_FEATURE_1, chip->image[CS4231_ALT_FEATURE_1]);
 	}
 	snd_wss_mce_down(chip);
 
-	scoped_guard(spinlock_irqsave, &chip->reg_lock) {
-		snd_wss_out(chip, CS4231_ALT_FEATURE_2,
-			    chip->image[CS4231_ALT_FEATURE_2]);
-	}
-
-	snd_wss_mce_up(chip);
-	scoped_guard(spinlock_irqsave, &chip->reg_lock) {
-		snd_wss_out(chip, CS4231_PLAYBK_FORMAT,
-			    chip->image[CS4231_PLAYBK_FORMAT]);
-	}
-	snd_wss_mce_down(chip);
-
-	snd_wss_mce_up(chip);
-	scoped_guard(spinlock_irqsave, &chip->reg_lock) {
-		if (!(chip->hardware & WSS_HW_AD1848_MASK))
-			snd_wss_out(chip, CS4231_REC_FORMAT,
-				    chip->image[CS4231_REC_FORMAT]);
-	}
-	snd_wss_mce_down(chip);
 	snd_wss_calibrate_mute(chip, 0);
 }
 
@@ -805,7 +1453,7 @@ static int snd_wss_open(struct snd_wss *chip, unsigned int mode)
 	}
 	/* ok. now enable and ack CODEC IRQ */
 	guard(spinlock_irqsave)(&chip->reg_lock);
-	if (!(chip->hardware & WSS_HW_AD1848_MASK)) {
+	if (!(snd_wss_hardware(chip) & WSS_HW_AD1848_MASK)) {
 		snd_wss_out(chip, CS4231_IRQ_STATUS,
 			    CS4231_PLAYBACK_IRQ |
 			    CS4231_RECORD_IRQ |
@@ -816,7 +1464,7 @@ static int snd_wss_open(struct snd_wss *chip, unsigned int mode)
 	wss_outb(chip, CS4231P(STATUS), 0);	/* clear IRQ */
 	chip->image[CS4231_PIN_CTRL] |= CS4231_IRQ_ENABLE;
 	snd_wss_out(chip, CS4231_PIN_CTRL, chip->image[CS4231_PIN_CTRL]);
-	if (!(chip->hardware & WSS_HW_AD1848_MASK)) {
+	if (!(snd_wss_hardware(chip) & WSS_HW_AD1848_MASK)) {
 		snd_wss_out(chip, CS4231_IRQ_STATUS,
 			    CS4231_PLAYBACK_IRQ |
 			    CS4231_RECORD_IRQ |
@@ -838,7 +1486,7 @@ static void snd_wss_close(struct snd_wss *chip, unsigned int mode)
 		return;
 	/* disable IRQ */
 	spin_lock_irqsave(&chip->reg_lock, flags);
-	if (!(chip->hardware & WSS_HW_AD1848_MASK))
+	if (!(snd_wss_hardware(chip) & WSS_HW_AD1848_MASK))
 		snd_wss_out(chip, CS4231_IRQ_STATUS, 0);
 	wss_outb(chip, CS4231P(STATUS), 0);	/* clear IRQ */
 	wss_outb(chip, CS4231P(STATUS), 0);	/* clear IRQ */
@@ -862,7 +1510,7 @@ static void snd_wss_close(struct snd_wss *chip, unsigned int mode)
 	}
 
 	/* clear IRQ again */
-	if (!(chip->hardware & WSS_HW_AD1848_MASK))
+	if (!(snd_wss_hardware(chip) & WSS_HW_AD1848_MASK))
 		snd_wss_out(chip, CS4231_IRQ_STATUS, 0);
 	wss_outb(chip, CS4231P(STATUS), 0);	/* clear IRQ */
 	wss_outb(chip, CS4231P(STATUS), 0);	/* clear IRQ */
@@ -871,6 +1519,7 @@ static void snd_wss_close(struct snd_wss *chip, unsigned int mode)
 	chip->mode = 0;
 }
 
+#ifdef CONFIG_SND_WSS_TIMER
 /*
  *  timer open/close
  */
@@ -900,21 +1549,57 @@ static const struct snd_timer_hardware snd_wss_timer_table =
 	.start =	snd_wss_timer_start,
 	.stop =		snd_wss_timer_stop,
 };
+#endif /* CONFIG_SND_WSS_TIMER */
 
 /*
  *  ok.. exported functions..
  */
 
+/* In CS4237B only builds the CS4236 callbacks are called directly. */
+static inline void snd_wss_set_playback_format(struct snd_wss *chip,
+					       struct snd_pcm_hw_params *params,
+					       unsigned char pdfr)
+{
+#ifdef CONFIG_SND_WSS_CS4237B_ONLY
+	snd_cs4236_playback_format(chip, params, pdfr);
+#else
+	chip->set_playback_format(chip, params, pdfr);
+#endif
+}
+
+static inline void snd_wss_set_capture_format(struct snd_wss *chip,
+					      struct snd_pcm_hw_params *params,
+					      unsigned char cdfr)
+{
+#ifdef CONFIG_SND_WSS_CS4237B_ONLY
+	snd_cs4236_capture_format(chip, params, cdfr);
+#else
+	chip->set_capture_format(chip, params, cdfr);
+#endif
+}
+
+static inline int snd_wss_rate_constraint(struct snd_wss *chip,
+					  struct snd_pcm_runtime *runtime)
+{
+#ifdef CONFIG_SND_WSS_CS4237B_ONLY
+	return snd_cs4236_xrate(runtime);
+#else
+	return chip->rate_constraint(runtime);
+#endif
+}
+
 static int snd_wss_playback_hw_params(struct snd_pcm_substream *substream,
 					 struct snd_pcm_hw_params *hw_params)
 {
 	struct snd_wss *chip = snd_pcm_substream_chip(substream);
 	unsigned char new_pdfr;
+	u64 start = local_clock();
 
 	new_pdfr = snd_wss_get_format(chip, params_format(hw_params),
 				params_channels(hw_params)) |
 				snd_wss_get_rate(params_rate(hw_params));
-	chip->set_playback_format(chip, hw_params, new_pdfr);
+	snd_wss_set_playback_format(chip, hw_params, new_pdfr);
+	snd_wss_stat_time_add(&chip->stats.hw_params, start);
 	return 0;
 }
 
@@ -935,13 +1620,31 @@ static int snd_wss_playback_hw_params(struct snd_pcm_substream *substream,
  * We should be in MODE 2 since MODE 2, forces the part to
  * appear as a CS4231 super set and is compatible
  * with the CS4232. */
+/* Bytes between two codec interrupts. When the application turned the period
+ * wakeups off, it's the whole buffer: a 64 KB buffer then gives a few interrupts
+ * per second instead of hundreds, and the pointer callback reads the DMA. */
+static unsigned int snd_wss_irq_bytes(struct snd_pcm_substream *substream)
+{
+	if (substream->runtime->no_period_wakeup)
+		return snd_pcm_lib_buffer_bytes(substream);
+	return snd_pcm_lib_period_bytes(substream);
+}
+
+/* The count registers are 16 bits of samples minus one. A whole buffer of 8-bit
+ * mono can be more than that; the interrupt then just comes a bit more often. */
+#define WSS_MAX_COUNT	65536U
+
 static int snd_wss_playback_prepare(struct snd_pcm_substream *substream)
 {
 	struct snd_wss *chip = snd_pcm_substream_chip(substream);
 	struct snd_pcm_runtime *runtime = substream->runtime;
 	unsigned int size = snd_pcm_lib_buffer_bytes(substream);
-	unsigned int count = snd_pcm_lib_period_bytes(substream);
+	unsigned int count = snd_wss_irq_bytes(substream);
+	u64 start = local_clock();
 
+	/* trigger can't sleep, so a calibration started in hw_params is waited
+	 * for here. Usually it's over by now. */
+	snd_wss_calib_wait(chip);
 	guard(spinlock_irqsave)(&chip->reg_lock);
 	chip->p_dma_size = size;
 	chip->image[CS4231_IFACE_CTRL] &= ~(CS4231_PLAYBACK_ENABLE | CS4231_PLAYBACK_PIO);
@@ -962,7 +1665,8 @@ static int snd_wss_playback_prepare(struct snd_pcm_substream *substream)
 	 *
 	 * This is a common pattern in hardware programming where registers follow the "N-1" encoding scheme for counters.
 	 * */
-	count = snd_wss_get_count(chip->image[CS4231_PLAYBK_FORMAT], count) - 1;
+	count = min(snd_wss_get_count(chip->image[CS4231_PLAYBK_FORMAT], count),
+		    WSS_MAX_COUNT) - 1;
 	/* CS4231_PLY_LWR_CNT is 0b0000 1111 
 	 * Playback Lower Base (I15)
 	 * Lower Base Bits: This register is the
@@ -989,6 +1693,7 @@ static int snd_wss_playback_prepare(struct snd_pcm_substream *substream)
 	 * back and Capture Base registers.
 	 * */
 	snd_wss_out(chip, CS4231_PLY_UPR_CNT, (unsigned char) (count >> 8));
+	snd_wss_stat_time_add(&chip->stats.prepare, start);
 	return 0;
 }
 
@@ -997,11 +1702,13 @@ static int snd_wss_capture_hw_params(struct snd_pcm_substream *substream,
 {
 	struct snd_wss *chip = snd_pcm_substream_chip(substream);
 	unsigned char new_cdfr;
+	u64 start = local_clock();
 
 	new_cdfr = snd_wss_get_format(chip, params_format(hw_params),
 			   params_channels(hw_params)) |
 			   snd_wss_get_rate(params_rate(hw_params));
-	chip->set_capture_format(chip, hw_params, new_cdfr);
+	snd_wss_set_capture_format(chip, hw_params, new_cdfr);
+	snd_wss_stat_time_add(&chip->stats.hw_params, start);
 	return 0;
 }
 
@@ -1010,22 +1717,27 @@ static int snd_wss_capture_prepare(struct snd_pcm_substream *substream)
 	struct snd_wss *chip = snd_pcm_substream_chip(substream);
 	struct snd_pcm_runtime *runtime = substream->runtime;
 	unsigned int size = snd_pcm_lib_buffer_bytes(substream);
-	unsigned int count = snd_pcm_lib_period_bytes(substream);
+	unsigned int count = snd_wss_irq_bytes(substream);
+	u64 start = local_clock();
 
+	/* Same as for snd_wss_playback_prepare. */
+	snd_wss_calib_wait(chip);
 	guard(spinlock_irqsave)(&chip->reg_lock);
 	chip->c_dma_size = size;
+	chip->overrange_next = jiffies;
 	chip->image[CS4231_IFACE_CTRL] &= ~(CS4231_RECORD_ENABLE | CS4231_RECORD_PIO);
 	snd_dma_program(chip->dma2, runtime->dma_addr, size, DMA_MODE_READ | DMA_AUTOINIT);
 	/* 560z is a CS4237B. simplifying */
 	/* the -1 is because sending a count of 0 will result in a DMA transfer so if
 	 * the count is 1 for 1 read, we need to send 0 */
-	count = snd_wss_get_count(chip->image[CS4231_REC_FORMAT],
-			count);
+	count = min(snd_wss_get_count(chip->image[CS4231_REC_FORMAT],
+			count), WSS_MAX_COUNT);
 	count--;
 	/* 560z is a 2 dma. simplifying*/
 	snd_wss_out(chip, CS4231_REC_LWR_CNT, (unsigned char) count);
 	snd_wss_out(chip, CS4231_REC_UPR_CNT,
 		(unsigned char) (count >> 8));
+	snd_wss_stat_time_add(&chip->stats.prepare, start);
 	return 0;
 }
 
@@ -1036,81 +1748,254 @@ void snd_wss_overrange(struct snd_wss *chip)
 	scoped_guard(spinlock_irqsave, &chip->reg_lock) {
 		res = snd_wss_in(chip, CS4231_TEST_INIT);
 	}
-	if (res & (0x08 | 0x02))	/* detect overrange only above 0dB; may be user selectable? */
+	chip->stats.overrange_reads++;
+	if (res & (0x08 | 0x02)) {	/* detect overrange only above 0dB; may be user selectable? */
 		chip->capture_substream->runtime->overrange++;
+		chip->stats.overrange_hits++;
+	}
 }
 EXPORT_SYMBOL(snd_wss_overrange);
 
-/* I think this handles interrupts duing playback and capture.
- * TODO figure out what snd_pcm_period_elapsed does. Since the sound
- * works, I didn't investigate further. */
-irqreturn_t snd_wss_interrupt(int irq, void *dev_id)
+/* I24 and I11 are sampled at most this often for the overrange count. */
+#define WSS_OVERRANGE_INTERVAL	(HZ / 10)
+
+/* Read I24 and clear the interrupt bits found there. Called with reg_lock held.
+ * The interrupts are never enabled while INIT is set, so I24 is accessed
+ * without snd_wss_wait. */
+static unsigned char snd_wss_irq_ack(struct snd_wss *chip)
 {
-	struct snd_wss *chip = dev_id;
 	unsigned char status;
 
-	/* 560z is a CS4237B. simplifying */
-	status = snd_wss_in(chip, CS4231_IRQ_STATUS);
+	wss_outb(chip, CS4231P(REGSEL), chip->mce_bit | CS4231_IRQ_STATUS);
+	status = wss_inb(chip, CS4231P(REG));
+	if (status & CS4231_ALL_IRQS) {
+		/* Clear only the bits found above so one which came
+		 * in meanwhile isn't lost. */
+		wss_outb(chip, CS4231P(REGSEL), chip->mce_bit | CS4231_IRQ_STATUS);
+		wss_outb(chip, CS4231P(REG), ~CS4231_ALL_IRQS | ~status);
+		chip->stats.irq_playback += !!(status & CS4231_PLAYBACK_IRQ);
+		chip->stats.irq_capture += !!(status & CS4231_RECORD_IRQ);
+		chip->stats.irq_timer += !!(status & CS4231_TIMER_IRQ);
+	} else {
+		/* INT without a known source: any write to R2 clears
+		 * all the interrupts. */
+		wss_outb(chip, CS4231P(STATUS), 0);
+		chip->stats.irq_unknown++;
+	}
+	trace_snd_wss_irq(chip, status);
+	return status;
+}
+
+/* Read the DMA position once per period, at the period interrupt. With
+ * interpolate_pointer the playback pointer callback moves on from there. */
+static void snd_wss_latch_pointer(struct snd_wss *chip, int dma, unsigned int size,
+				  size_t *ptr, u64 *time)
+{
+	if (!interpolate_pointer)
+		return;
+	guard(spinlock_irqsave)(&chip->reg_lock);
+	*ptr = snd_dma_pointer(dma, size);
+	*time = local_clock();
+	chip->stats.pointer_dma_reads++;
+}
+
+/* Period, timer and overrange notification for the I24 bits in status. */
+static void snd_wss_irq_notify(struct snd_wss *chip, unsigned char status)
+{
 	if (status & CS4231_TIMER_IRQ) {
 		if (chip->timer)
 			snd_timer_interrupt(chip->timer, chip->timer->sticks);
 	}
 	/* 560z is a 2 dma. simplifying*/
 	if (status & CS4231_PLAYBACK_IRQ) {
-		if (chip->playback_substream)
+		if (chip->playback_substream) {
+			snd_wss_latch_pointer(chip, chip->dma1, chip->p_dma_size,
+					      &chip->p_ptr, &chip->p_ptr_time);
 			snd_pcm_period_elapsed(chip->playback_substream);
+		}
 	}
 	if (status & CS4231_RECORD_IRQ) {
 		if (chip->capture_substream) {
-			snd_wss_overrange(chip);
+			/* The overrange count is a hint for level meters, it
+			 * doesn't need a second indirect read every period. */
+			if (time_after_eq(jiffies, chip->overrange_next)) {
+				chip->overrange_next = jiffies + WSS_OVERRANGE_INTERVAL;
+				snd_wss_overrange(chip);
+			}
 			snd_pcm_period_elapsed(chip->capture_substream);
 		}
 	}
+}
 
-	guard(spinlock)(&chip->reg_lock);
-	status = ~CS4231_ALL_IRQS | ~status;
-	snd_wss_out(chip, CS4231_IRQ_STATUS, status);
+/* I think this handles interrupts duing playback and capture.
+ * TODO figure out what snd_pcm_period_elapsed does. Since the sound
+ * works, I didn't investigate further.
+ * With 64 byte periods this runs thousands of times per second, so it
+ * reads R2 first and only goes through R0/R1 when the codec has an
+ * interrupt pending. */
+irqreturn_t snd_wss_interrupt(int irq, void *dev_id)
+{
+	struct snd_wss *chip = dev_id;
+	u64 start = local_clock();
+	unsigned char status;
+
+	/* Status (R2) D0 is INT: set when any of the I24 interrupt bits is set.
+	 * R2 is a direct register, no index and no INIT wait needed. */
+	if (!(wss_inb(chip, CS4231P(STATUS)) & CS4231_GLOBALIRQ))
+		return IRQ_NONE;
+
+	/* 560z is a CS4237B. simplifying */
+	scoped_guard(spinlock, &chip->reg_lock)
+		status = snd_wss_irq_ack(chip);
+	snd_wss_irq_notify(chip, status);
+	snd_wss_irqoff_account(chip, WSS_IRQOFF_INTERRUPT, start);
 	return IRQ_HANDLED;
 }
 EXPORT_SYMBOL(snd_wss_interrupt);
 
+/* Hard half with threaded_irq: only R2 and I24 are touched here. The bits
+ * are kept in chip->irq_status for snd_wss_irq_thread, so the other devices
+ * on the 560z IRQ lines wait less. */
+static irqreturn_t snd_wss_irq_hard(int irq, void *dev_id)
+{
+	struct snd_wss *chip = dev_id;
+	u64 start = local_clock();
+
+	if (!(wss_inb(chip, CS4231P(STATUS)) & CS4231_GLOBALIRQ))
+		return IRQ_NONE;
+
+	scoped_guard(spinlock, &chip->reg_lock)
+		chip->irq_status |= snd_wss_irq_ack(chip) & CS4231_ALL_IRQS;
+	snd_wss_irqoff_account(chip, WSS_IRQOFF_INTERRUPT, start);
+	return IRQ_WAKE_THREAD;
+}
+
+static irqreturn_t snd_wss_irq_thread(int irq, void *dev_id)
+{
+	struct snd_wss *chip = dev_id;
+	unsigned char status;
+
+	scoped_guard(spinlock_irqsave, &chip->reg_lock) {
+		status = chip->irq_status;
+		chip->irq_status = 0;
+	}
+	snd_wss_irq_notify(chip, status);
+	return IRQ_HANDLED;
+}
+
+/* snd_dma_pointer latches and reads the 8237 count over ISA with the DMA lock
+ * held, and ALSA asks for the pointer on every hw_ptr update and every
+ * poll/avail. With interpolate_pointer, the position read at the last period
+ * interrupt is moved forward by the time since then at the stream rate instead.
+ * It stays one frame short of the next period, but a DMA running late behind
+ * the clock would still be passed, so it's off by default and only for
+ * playback: a capture pointer ahead of the DMA hands out frames not written
+ * yet. */
+static snd_pcm_uframes_t snd_wss_pointer(struct snd_wss *chip,
+					 struct snd_pcm_substream *substream,
+					 int dma, unsigned int size,
+					 size_t ptr, u64 time)
+{
+	struct snd_pcm_runtime *runtime = substream->runtime;
+	size_t moved, limit;
+
+	chip->stats.pointer_calls++;
+	/* Without period interrupts there's nothing to interpolate from. */
+	if (!interpolate_pointer || runtime->no_period_wakeup) {
+		chip->stats.pointer_dma_reads++;
+		return bytes_to_frames(runtime, snd_dma_pointer(dma, size));
+	}
+	moved = div_u64((local_clock() - time) * frames_to_bytes(runtime, runtime->rate),
+			NSEC_PER_SEC);
+	limit = snd_pcm_lib_period_bytes(substream) - frames_to_bytes(runtime, 1);
+	ptr = (ptr + min(moved, limit)) % size;
+	return bytes_to_frames(runtime, ptr);
+}
+
 static snd_pcm_uframes_t snd_wss_playback_pointer(struct snd_pcm_substream *substream)
 {
 	struct snd_wss *chip = snd_pcm_substream_chip(substream);
-	size_t ptr;
 
 	if (!(chip->image[CS4231_IFACE_CTRL] & CS4231_PLAYBACK_ENABLE))
-		return 0;
-	ptr = snd_dma_pointer(chip->dma1, chip->p_dma_size);
-	return bytes_to_frames(substream->runtime, ptr);
+		return chip->paused & CS4231_PLAYBACK_ENABLE ?
+			bytes_to_frames(substream->runtime, chip->p_ptr) : 0;
+	guard(spinlock_irqsave)(&chip->reg_lock);
+	return snd_wss_pointer(chip, substream, chip->dma1, chip->p_dma_size,
+			       chip->p_ptr, chip->p_ptr_time);
 }
 
 static snd_pcm_uframes_t snd_wss_capture_pointer(struct snd_pcm_substream *substream)
 {
 	struct snd_wss *chip = snd_pcm_substream_chip(substream);
-	size_t ptr;
 
 	if (!(chip->image[CS4231_IFACE_CTRL] & CS4231_RECORD_ENABLE))
+		return chip->paused & CS4231_RECORD_ENABLE ?
+			bytes_to_frames(substream->runtime, chip->c_ptr) : 0;
+	guard(spinlock_irqsave)(&chip->reg_lock);
+	chip->stats.pointer_calls++;
+	chip->stats.pointer_dma_reads++;
+	return bytes_to_frames(substream->runtime,
+			       snd_dma_pointer(chip->dma2, chip->c_dma_size));
+}
+
+/* Link timestamp: the DMA residue read from the 8237 right now, paired with the
+ * system time taken just after. Players and jackd then get the real delay
+ * instead of guessing it and can run with smaller buffers.
+ * The codec FIFO holds 16 samples between the DMA and the DAC/ADC, that's the
+ * accuracy reported. */
+static int snd_wss_get_time_info(struct snd_pcm_substream *substream,
+				 struct timespec64 *system_ts, struct timespec64 *audio_ts,
+				 struct snd_pcm_audio_tstamp_config *audio_tstamp_config,
+				 struct snd_pcm_audio_tstamp_report *audio_tstamp_report)
+{
+	struct snd_wss *chip = snd_pcm_substream_chip(substream);
+	struct snd_pcm_runtime *runtime = substream->runtime;
+	snd_pcm_uframes_t pos, hw_pos;
+	size_t ptr;
+
+	if (audio_tstamp_config->type_requested != SNDRV_PCM_AUDIO_TSTAMP_TYPE_LINK) {
+		audio_tstamp_report->actual_type = SNDRV_PCM_AUDIO_TSTAMP_TYPE_DEFAULT;
 		return 0;
-	ptr = snd_dma_pointer(chip->dma2, chip->c_dma_size);
-	return bytes_to_frames(substream->runtime, ptr);
+	}
+
+	scoped_guard(spinlock_irqsave, &chip->reg_lock) {
+		chip->stats.pointer_dma_reads++;
+		if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK)
+			ptr = snd_dma_pointer(chip->dma1, chip->p_dma_size);
+		else
+			ptr = snd_dma_pointer(chip->dma2, chip->c_dma_size);
+		snd_pcm_gettime(runtime, system_ts);
+	}
+	/* Frames since the stream started. The DMA may have wrapped around the
+	 * buffer since hw_ptr was last updated. */
+	pos = bytes_to_frames(runtime, ptr);
+	hw_pos = runtime->status->hw_ptr - runtime->hw_ptr_base;
+	if (pos < hw_pos)
+		pos += runtime->buffer_size;
+	pos += runtime->hw_ptr_base;
+	*audio_ts = ns_to_timespec64(div_u64((u64)pos * NSEC_PER_SEC, runtime->rate));
+
+	audio_tstamp_report->actual_type = SNDRV_PCM_AUDIO_TSTAMP_TYPE_LINK;
+	audio_tstamp_report->accuracy_report = 1;
+	audio_tstamp_report->accuracy = div_u64(16ULL * NSEC_PER_SEC, runtime->rate);
+	return 0;
 }
 
 /* probe the card and fill information such as hardware.
  * For my 560z, chip->hardware is WSS_HW_CS4237B */
-static int snd_wss_probe(struct snd_wss *chip)
+/* was_reset tells snd_wss_init if the codec is still in its reset state. */
+static int snd_wss_probe(struct snd_wss *chip, bool *was_reset)
 {
-	int i, id, rev, regnum;
-	unsigned char *ptr;
-	unsigned int hw;
+	int id, rev;
 
-	hw = chip->hardware;
 	/* Below is a bit difficult to understand because I heavily modified the code
 	 * and hard-coded values which I know from testing do work with the 560z. */
 	/* I kept only down here from the "if ((hw & WSS_HW_TYPE_MASK) == WSS_HW_DETECT)" code block */
 	/* scoped_guard was added when I rewrote for 6.18.8
 	 * it was only a guard within a scope, but since I'm hard-coding values, I needed
 	 * a scoped guard. */
+	/* Checked before MODE 3 is set below, and before reg_lock since it sleeps. */
+	*was_reset = snd_wss_codec_was_reset(chip);
 	scoped_guard(spinlock_irqsave, &chip->reg_lock) {
 		/* CS4231_MISC_INFO is 0x0c so I12
 		 * MODE and ID (I12)
@@ -1217,25 +2102,8 @@ static int snd_wss_probe(struct snd_wss *chip)
 	chip->image[CS4231_MISC_INFO] = CS4231_4236_MODE3;
 	/* 560z is a 2 dma. simplifying*/
 	chip->image[CS4231_IFACE_CTRL] = chip->image[CS4231_IFACE_CTRL] & ~CS4231_SINGLE_DMA;
-	/* 560z is a CS4237B. simplifying */
-	ptr = (unsigned char *) &chip->image;
-	/* 560z is a CS4237B. simplifying */
-	regnum = 32;
-	snd_wss_mce_down(chip);
-	scoped_guard(spinlock_irqsave, &chip->reg_lock) {
-	/* TODO figure out why we set each indirect register...
-	 * From what I have seen, this is not entirely needed. We could skip
-	 * a number of registers, but since the sound is working now, I didn't
-	 * continue the investigation.
-	 * Setting the MODE3 on CMS1,0 bits in I12 here. */
-		for (i = 0; i < regnum; i++)	/* ok.. fill all registers */
-			snd_wss_out(chip, i, *ptr++);
-	}
-	snd_wss_mce_up(chip);
-	snd_wss_mce_down(chip);
-
-	/* TODO can this delay be removed? Sound is working; didn't continue the investigation. */
-	mdelay(2);
+	/* The registers used to be all filled here between two MCE cycles, followed
+	 * by a mdelay(2). snd_wss_init now writes them in its single MCE window. */
 
 	return 0;		/* all things are ok.. */
 }
@@ -1248,7 +2116,11 @@ static const struct snd_pcm_hardware snd_wss_playback =
 {
 	.info =			(SNDRV_PCM_INFO_MMAP | SNDRV_PCM_INFO_INTERLEAVED |
 				 SNDRV_PCM_INFO_MMAP_VALID |
-				 SNDRV_PCM_INFO_SYNC_START),
+				 SNDRV_PCM_INFO_RESUME |
+				 SNDRV_PCM_INFO_SYNC_START |
+				 SNDRV_PCM_INFO_HAS_LINK_ATIME |
+				 SNDRV_PCM_INFO_NO_PERIOD_WAKEUP |
+				 SNDRV_PCM_INFO_PAUSE),
 	.formats =		(SNDRV_PCM_FMTBIT_MU_LAW | SNDRV_PCM_FMTBIT_A_LAW | SNDRV_PCM_FMTBIT_IMA_ADPCM |
 				 SNDRV_PCM_FMTBIT_U8 | SNDRV_PCM_FMTBIT_S16_LE | SNDRV_PCM_FMTBIT_S16_BE),
 	.rates =		SNDRV_PCM_RATE_KNOT | SNDRV_PCM_RATE_8000_48000,
@@ -1269,7 +2141,10 @@ static const struct snd_pcm_hardware snd_wss_capture =
 	.info =			(SNDRV_PCM_INFO_MMAP | SNDRV_PCM_INFO_INTERLEAVED |
 				 SNDRV_PCM_INFO_MMAP_VALID |
 				 SNDRV_PCM_INFO_RESUME |
-				 SNDRV_PCM_INFO_SYNC_START),
+				 SNDRV_PCM_INFO_SYNC_START |
+				 SNDRV_PCM_INFO_HAS_LINK_ATIME |
+				 SNDRV_PCM_INFO_NO_PERIOD_WAKEUP |
+				 SNDRV_PCM_INFO_PAUSE),
 	.formats =		(SNDRV_PCM_FMTBIT_MU_LAW | SNDRV_PCM_FMTBIT_A_LAW | SNDRV_PCM_FMTBIT_IMA_ADPCM |
 				 SNDRV_PCM_FMTBIT_U8 | SNDRV_PCM_FMTBIT_S16_LE | SNDRV_PCM_FMTBIT_S16_BE),
 	.rates =		SNDRV_PCM_RATE_KNOT | SNDRV_PCM_RATE_8000_48000,
@@ -1314,7 +2189,7 @@ static int snd_wss_playback_open(struct snd_pcm_substream *substream)
 	}
 	chip->playback_substream = substream;
 	snd_pcm_set_sync(substream);
-	chip->rate_constraint(runtime);
+	snd_wss_rate_constraint(chip, runtime);
 	return 0;
 }
 
@@ -1343,7 +2218,7 @@ static int snd_wss_capture_open(struct snd_pcm_substream *substream)
 	}
 	chip->capture_substream = substream;
 	snd_pcm_set_sync(substream);
-	chip->rate_constraint(runtime);
+	snd_wss_rate_constraint(chip, runtime);
 	return 0;
 }
 
@@ -1368,35 +2243,48 @@ static int snd_wss_capture_close(struct snd_pcm_substream *substream)
 
 #ifdef CONFIG_PM
 
-/* lowlevel suspend callback for CS4231 */
+/* lowlevel suspend callback for CS4231
+ * Every write goes through snd_wss_out/snd_wss_out_batch which keep chip->image
+ * up to date, and the registers the codec changes by itself (I11, I24, I25) are
+ * never written back. So there's nothing to read from the codec here. */
 static void snd_wss_suspend(struct snd_wss *chip)
 {
-	int reg;
-
+	/* Deferred writes are already in the image. They never reached the codec,
+	 * so they are the ones resume writes back when the codec kept the rest. */
+	flush_work(&chip->calib_work);
+	cancel_delayed_work_sync(&chip->pending_work);
 	scoped_guard(spinlock_irqsave, &chip->reg_lock) {
-		for (reg = 0; reg < 32; reg++)
-			chip->image[reg] = snd_wss_in(chip, reg);
+		chip->dirty_regs |= chip->pending_regs | chip->mixer_regs;
+		chip->dirty_eregs |= chip->pending_eregs | chip->mixer_eregs;
+		chip->pending_regs = 0;
+		chip->pending_eregs = 0;
+		chip->mixer_regs = 0;
+		chip->mixer_eregs = 0;
+		chip->dma_lost = chip->paused;
 	}
+	/* Nothing is known about the codec until snd_wss_resume calibrated it. */
+	chip->calibrated = false;
 }
 
 /* lowlevel resume callback for CS4231 */
 static void snd_wss_resume(struct snd_wss *chip)
 {
-	int reg;
+	struct snd_wss_reg_val regs[32];
+	unsigned int count;
+	bool was_reset = snd_wss_codec_was_reset(chip);
 
 	snd_wss_mce_up(chip);
 	scoped_guard(spinlock_irqsave, &chip->reg_lock) {
-		for (reg = 0; reg < 32; reg++) {
-			switch (reg) {
-			case CS4231_VERSION:
-				break;
-			default:
-				snd_wss_out(chip, reg, chip->image[reg]);
-				break;
-			}
-		}
+		/* If the codec was reset, only the registers which differ from
+		 * their reset value need to be written. Otherwise the codec still
+		 * has everything but the writes suspend dropped. */
+		count = snd_wss_image_regs(chip, regs,
+					   was_reset ? 0 : ~chip->dirty_regs, was_reset);
+		chip->dirty_regs = 0;
+		chip->dirty_eregs = 0;
+		snd_wss_out_batch(chip, regs, count);
 		/* Yamaha needs this to resume properly */
-		if (chip->hardware == WSS_HW_OPL3SA2)
+		if (snd_wss_hardware(chip) == WSS_HW_OPL3SA2)
 			snd_wss_out(chip, CS4231_PLAYBK_FORMAT,
 				    chip->image[CS4231_PLAYBK_FORMAT]);
 	}
@@ -1428,6 +2316,9 @@ static void snd_wss_resume(struct snd_wss *chip)
 
 const char *snd_wss_chip_id(struct snd_wss *chip)
 {
+#ifdef CONFIG_SND_WSS_CS4237B_ONLY
+	return "CS4237B";
+#else
 	switch (chip->hardware) {
 	case WSS_HW_CS4231:
 		return "CS4231";
@@ -1468,6 +2359,7 @@ const char *snd_wss_chip_id(struct snd_wss *chip)
 	default:
 		return "???";
 	}
+#endif
 }
 EXPORT_SYMBOL(snd_wss_chip_id);
 
@@ -1488,17 +2380,24 @@ static int snd_wss_new(struct snd_card *card,
 	spin_lock_init(&chip->reg_lock);
 	mutex_init(&chip->mce_mutex);
 	mutex_init(&chip->open_mutex);
+	INIT_DELAYED_WORK(&chip->pending_work, snd_wss_pending_work);
+	INIT_WORK(&chip->calib_work, snd_wss_calib_work);
+	/* No calibration is running to begin with. */
+	init_completion(&chip->calib_done);
+	complete_all(&chip->calib_done);
 	chip->card = card;
 	chip->rate_constraint = snd_wss_xrate;
 	chip->set_playback_format = snd_wss_playback_format;
 	chip->set_capture_format = snd_wss_capture_format;
+#ifndef CONFIG_SND_WSS_CS4237B_ONLY
 	if (chip->hardware == WSS_HW_OPTI93X)
 		memcpy(&chip->image, &snd_opti93x_original_image,
 		       sizeof(snd_opti93x_original_image));
 	else
+#endif
 		memcpy(&chip->image, &snd_wss_original_image,
 		       sizeof(snd_wss_original_image));
-	if (chip->hardware & WSS_HW_AD1848_MASK) {
+	if (snd_wss_hardware(chip) & WSS_HW_AD1848_MASK) {
 		chip->image[CS4231_PIN_CTRL] = 0;
 		chip->image[CS4231_TEST_INIT] = 0;
 	}
@@ -1507,6 +2406,201 @@ static int snd_wss_new(struct snd_card *card,
 	return 0;
 }
 
+static void snd_wss_proc_stat_time(struct snd_info_buffer *buffer, const char *name,
+				   const struct snd_wss_stat_time *t)
+{
+	snd_iprintf(buffer, "%s calls\t%u\n", name, t->count);
+	snd_iprintf(buffer, "%s max (us)\t%u\n", name, t->max_us);
+	snd_iprintf(buffer, "%s total (us)\t%llu\n", name, t->total_us);
+}
+
+static void snd_wss_proc_stats_read(struct snd_info_entry *entry,
+				    struct snd_info_buffer *buffer)
+{
+	static const char * const irqoff_names[WSS_IRQOFF_SITES] = {
+		[WSS_IRQOFF_OUT]		= "snd_wss_out",
+		[WSS_IRQOFF_OUT_BATCH]		= "snd_wss_out_batch",
+		[WSS_IRQOFF_IN]			= "snd_wss_in",
+		[WSS_IRQOFF_EXT_OUT]		= "snd_cs4236_ext_out",
+		[WSS_IRQOFF_EXT_OUT_BATCH]	= "snd_cs4236_ext_out_batch",
+		[WSS_IRQOFF_EXT_IN]		= "snd_cs4236_ext_in",
+		[WSS_IRQOFF_MCE]		= "snd_wss_mce_up/down",
+		[WSS_IRQOFF_INTERRUPT]		= "snd_wss_interrupt",
+		[WSS_IRQOFF_TRIGGER]		= "snd_wss_trigger",
+	};
+	struct snd_wss *chip = entry->private_data;
+	int i;
+
+	snd_iprintf(buffer, "irqoff budget (us)\t%u\n", WSS_IRQOFF_BUDGET_US);
+	for (i = 0; i < WSS_IRQOFF_SITES; i++)
+		snd_iprintf(buffer, "irqoff max (ns) %s\t%u\n",
+			    irqoff_names[i], chip->stats.irqoff_max_ns[i]);
+	snd_iprintf(buffer, "deferred writes\t%u\n", chip->stats.deferred_writes);
+	snd_iprintf(buffer, "deferred flushes\t%u\n", chip->stats.deferred_flushes);
+	snd_iprintf(buffer, "busy wait (us) 0\t%u\n", chip->stats.busy_wait_hist[0]);
+	snd_iprintf(buffer, "busy wait (us) 1-1000\t%u\n", chip->stats.busy_wait_hist[1]);
+	snd_iprintf(buffer, "busy wait (us) 1001-10000\t%u\n", chip->stats.busy_wait_hist[2]);
+	snd_iprintf(buffer, "busy wait (us) 10001-100000\t%u\n", chip->stats.busy_wait_hist[3]);
+	snd_iprintf(buffer, "busy wait (us) >100000\t%u\n", chip->stats.busy_wait_hist[4]);
+	snd_iprintf(buffer, "busy wait timeouts\t%u\n", chip->stats.busy_wait_timeouts);
+	snd_iprintf(buffer, "busy wait max (us)\t%u\n", chip->stats.busy_wait_max_us);
+	snd_iprintf(buffer, "busy wait total (us)\t%llu\n", chip->stats.busy_wait_total_us);
+	snd_iprintf(buffer, "mixer writes\t%u\n", chip->stats.mixer_writes);
+	snd_iprintf(buffer, "mixer registers written\t%u\n", chip->stats.mixer_flushed);
+	snd_iprintf(buffer, "pointer calls\t%u\n", chip->stats.pointer_calls);
+	snd_iprintf(buffer, "pointer DMA reads\t%u\n", chip->stats.pointer_dma_reads);
+	snd_iprintf(buffer, "I register writes\t%u\n", chip->stats.reg_writes);
+	snd_iprintf(buffer, "I register reads\t%u\n", chip->stats.reg_reads);
+	snd_iprintf(buffer, "X register writes\t%u\n", chip->stats.ereg_writes);
+	snd_iprintf(buffer, "X register reads\t%u\n", chip->stats.ereg_reads);
+	snd_wss_proc_stat_time(buffer, "wait delay", &chip->stats.wait_delay);
+	snd_iprintf(buffer, "MCE cycles\t%u\n", chip->stats.mce_cycles);
+	snd_wss_proc_stat_time(buffer, "calibration", &chip->stats.calib);
+	snd_iprintf(buffer, "calibration timeouts\t%u\n", chip->stats.calib_timeouts);
+	snd_iprintf(buffer, "INIT read timeouts\t%u\n", chip->stats.init_read_timeouts);
+	snd_iprintf(buffer, "IRQ playback\t%u\n", chip->stats.irq_playback);
+	snd_iprintf(buffer, "IRQ capture\t%u\n", chip->stats.irq_capture);
+	snd_iprintf(buffer, "IRQ timer\t%u\n", chip->stats.irq_timer);
+	snd_iprintf(buffer, "IRQ unknown source\t%u\n", chip->stats.irq_unknown);
+	snd_iprintf(buffer, "overrange reads\t%u\n", chip->stats.overrange_reads);
+	snd_iprintf(buffer, "overrange hits\t%u\n", chip->stats.overrange_hits);
+	snd_wss_proc_stat_time(buffer, "hw_params", &chip->stats.hw_params);
+	snd_wss_proc_stat_time(buffer, "prepare", &chip->stats.prepare);
+}
+
+/*
+ *  /proc/asound/cardX/wss_regs
+ *
+ *  Some of the comments above say registers "go to wrong values" and the fix was
+ *  to run alsactl init again. Reading this file reads I0-I31 and X0-X25 from the
+ *  codec in one reg_lock section and puts chip->image/eimage next to them:
+ *    I12	0xea	0xe0
+ *    I6	0x3f	0x00	drift
+ *  "drift" means the codec doesn't have what the driver last wrote, "pending"
+ *  means the value is still waiting in the image for snd_wss_pending_work. The
+ *  volatile registers and X18-X25, which the driver doesn't keep, have no image
+ *  column. Only the bits the datasheet lets us write and read back are compared:
+ *  the chip ID in I12 and the "res" bits, which "could read as 0 or 1", differ
+ *  from the image on a healthy codec. The 142 I/O of a snapshot are about
+ *  140 us with interrupts off.
+ *
+ *  Writing "I6 0x3f" or "X14 0x10" sets one register through snd_wss_out or
+ *  snd_cs4236_ext_out, so the image follows. I8, I9 and I28 get an MCE window.
+ */
+#define WSS_EXT_REGS		26	/* X0-X25 */
+#define WSS_EXT_IMAGE_REGS	18	/* X0-X17, the ones in chip->eimage */
+
+/* The bits of I0-I31 which read back what was written, from the CS4237B
+ * datasheet register descriptions. Read-only, "res" and TEST bits are 0.
+ * D6 of I6/I7 is LDG6/RDG6 or reserved depending on IFM and WTEN, so it's
+ * left out. */
+static const unsigned char snd_wss_rw_mask[32] = {
+	0xef, 0xef, 0xff, 0xff, 0xdf, 0xdf, 0xbf, 0xbf,	/* I0-I7 */
+	0xff, 0xdf, 0xfe, 0x00, 0x60, 0xfd, 0xff, 0xff,	/* I8-I15 */
+	0xff, 0x0b, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00,	/* I16-I23 */
+	0x00, 0x00, 0xef, 0x00, 0xf0, 0x00, 0xff, 0xff,	/* I24-I31 */
+};
+
+/* Same for X0-X17. */
+static const unsigned char snd_cs4236_rw_emask[WSS_EXT_IMAGE_REGS] = {
+	0xff, 0xff, 0xff, 0xff, 0xfc, 0xe0, 0xbf, 0xbf,	/* X0-X7 */
+	0xbf, 0xbf, 0xbf, 0xe0, 0xff, 0xff, 0xff, 0xff,	/* X8-X15 */
+	0xbf, 0xbf,					/* X16-X17 */
+};
+
+static void snd_wss_proc_regs_read(struct snd_info_entry *entry,
+				   struct snd_info_buffer *buffer)
+{
+	struct snd_wss *chip = entry->private_data;
+	unsigned char regs[32], image[32], eregs[WSS_EXT_REGS], eimage[32];
+	unsigned int pending, epending, drift = 0;
+	bool moved;
+	int reg;
+
+	snd_wss_calib_wait(chip);
+	guard(mutex)(&chip->mce_mutex);
+	/* A snapshot taken while INIT is set is all 0x80, so give the codec its
+	 * 25 ms with interrupts on before the reads below. */
+	snd_wss_init_wait(chip);
+	scoped_guard(spinlock_irqsave, &chip->reg_lock) {
+		if (!snd_wss_init_ready(chip)) {
+			snd_iprintf(buffer, "INIT is set, try again\n");
+			return;
+		}
+		for (reg = 0; reg < 32; reg++) {
+			wss_outb(chip, CS4231P(REGSEL), chip->mce_bit | reg);
+			regs[reg] = wss_inb(chip, CS4231P(REG));
+		}
+		for (reg = 0; reg < WSS_EXT_REGS; reg++) {
+			wss_outb(chip, CS4231P(REGSEL), chip->mce_bit | CS4236_EXT_REG);
+			wss_outb(chip, CS4231P(REG), CS4236_I23VAL(reg) |
+				 (chip->image[CS4236_EXT_REG] & 0x01));
+			eregs[reg] = wss_inb(chip, CS4231P(REG));
+		}
+		memcpy(image, chip->image, sizeof(image));
+		memcpy(eimage, chip->eimage, sizeof(eimage));
+		pending = chip->pending_regs | chip->mixer_regs;
+		epending = chip->pending_eregs | chip->mixer_eregs;
+		chip->stats.reg_reads += 32;
+		chip->stats.ereg_reads += WSS_EXT_REGS;
+	}
+
+	for (reg = 0; reg < 32; reg++) {
+		if (WSS_VOLATILE_REGS & BIT(reg)) {
+			snd_iprintf(buffer, "I%d\t0x%02x\n", reg, regs[reg]);
+			continue;
+		}
+		moved = (regs[reg] ^ image[reg]) & snd_wss_rw_mask[reg];
+		snd_iprintf(buffer, "I%d\t0x%02x\t0x%02x%s\n", reg, regs[reg], image[reg],
+			    pending & BIT(reg) ? "\tpending" : moved ? "\tdrift" : "");
+		drift += !(pending & BIT(reg)) && moved;
+	}
+	for (reg = 0; reg < WSS_EXT_REGS; reg++) {
+		if (reg >= WSS_EXT_IMAGE_REGS) {
+			snd_iprintf(buffer, "X%d\t0x%02x\n", reg, eregs[reg]);
+			continue;
+		}
+		moved = (eregs[reg] ^ eimage[reg]) & snd_cs4236_rw_emask[reg];
+		snd_iprintf(buffer, "X%d\t0x%02x\t0x%02x%s\n", reg, eregs[reg], eimage[reg],
+			    epending & BIT(reg) ? "\tpending" : moved ? "\tdrift" : "");
+		drift += !(epending & BIT(reg)) && moved;
+	}
+	snd_iprintf(buffer, "drift\t%u\n", drift);
+}
+
+static void snd_wss_proc_regs_write(struct snd_info_entry *entry,
+				    struct snd_info_buffer *buffer)
+{
+	struct snd_wss *chip = entry->private_data;
+	char line[64], bank;
+	unsigned int reg, val;
+	bool mce;
+
+	while (!snd_info_get_line(buffer, line, sizeof(line))) {
+		if (sscanf(line, "%c%u %x", &bank, &reg, &val) != 3 || val > 0xff ||
+		    (bank == 'I' && (reg >= 32 || (WSS_VOLATILE_REGS & BIT(reg)))) ||
+		    (bank == 'X' && reg >= WSS_EXT_IMAGE_REGS) ||
+		    (bank != 'I' && bank != 'X')) {
+			dev_err(chip->card->dev, "wss_regs: can't write \"%s\"\n", line);
+			continue;
+		}
+		snd_wss_calib_wait(chip);
+		guard(mutex)(&chip->mce_mutex);
+		mce = bank == 'I' && (WSS_MCE_REGS & BIT(reg)) &&
+		      !(chip->mce_bit & CS4231_MCE);
+		if (mce)
+			snd_wss_mce_up(chip);
+		scoped_guard(spinlock_irqsave, &chip->reg_lock) {
+			if (bank == 'I')
+				snd_wss_out(chip, reg, val);
+			else
+				snd_cs4236_ext_out(chip, CS4236_I23VAL(reg), val);
+		}
+		if (mce)
+			snd_wss_mce_down(chip);
+	}
+}
+
 int snd_wss_create(struct snd_card *card,
 		      unsigned long port,
 		      int irq, int dma1, int dma2,
@@ -1515,6 +2609,8 @@ int snd_wss_create(struct snd_card *card,
 		      struct snd_wss **rchip)
 {
 	struct snd_wss *chip;
+	bool was_reset;
+	u64 start;
 	int err;
 
 	err = snd_wss_new(card, hardware, hwshare, &chip);
@@ -1531,12 +2627,18 @@ int snd_wss_create(struct snd_card *card,
 		return -EBUSY;
 	}
 	chip->port = port;
-	if (!(hwshare & WSS_HWSHARE_IRQ))
-		if (devm_request_irq(card->dev, irq, snd_wss_interrupt, 0,
-				     "WSS", (void *) chip)) {
+	if (!(hwshare & WSS_HWSHARE_IRQ)) {
+		if (threaded_irq)
+			err = devm_request_threaded_irq(card->dev, irq, snd_wss_irq_hard,
+							snd_wss_irq_thread, 0, "WSS", chip);
+		else
+			err = devm_request_irq(card->dev, irq, snd_wss_interrupt, 0,
+					       "WSS", (void *) chip);
+		if (err) {
 			dev_err(chip->card->dev, "wss: can't grab IRQ %d\n", irq);
 			return -EBUSY;
 		}
+	}
 	chip->irq = irq;
 	card->sync_irq = chip->irq;
 	if (!(hwshare & WSS_HWSHARE_DMA1) &&
@@ -1554,10 +2656,20 @@ int snd_wss_create(struct snd_card *card,
 	 * and all the code related to it. */
 	chip->dma2 = dma2;
 
+	/* Registered after the port so the deferred writes are cancelled
+	 * before the port is released. */
+	err = devm_add_action_or_reset(card->dev, snd_wss_cancel_pending, chip);
+	if (err < 0)
+		return err;
+
 	/* global setup */
-	if (snd_wss_probe(chip) < 0)
+	start = local_clock();
+	if (snd_wss_probe(chip, &was_reset) < 0)
 		return -ENODEV;
-	snd_wss_init(chip);
+	snd_wss_init(chip, was_reset);
+	dev_dbg(chip->card->dev, "wss: probe and init took %llu us (codec %s)\n",
+		div_u64(local_clock() - start, NSEC_PER_USEC),
+		was_reset ? "from reset" : "already programmed");
 
 #if 0
 	if (chip->hardware & WSS_HW_CS4232_MASK) {
@@ -1573,6 +2685,10 @@ int snd_wss_create(struct snd_card *card,
 	chip->resume = snd_wss_resume;
 #endif
 
+	snd_card_ro_proc_new(card, "wss_stats", chip, snd_wss_proc_stats_read);
+	snd_card_rw_proc_new(card, "wss_regs", chip, snd_wss_proc_regs_read,
+			     snd_wss_proc_regs_write);
+
 	*rchip = chip;
 	return 0;
 }
@@ -1585,6 +2701,7 @@ static const struct snd_pcm_ops snd_wss_playback_ops = {
 	.prepare =	snd_wss_playback_prepare,
 	.trigger =	snd_wss_trigger,
 	.pointer =	snd_wss_playback_pointer,
+	.get_time_info = snd_wss_get_time_info,
 };
 
 static const struct snd_pcm_ops snd_wss_capture_ops = {
@@ -1594,6 +2711,7 @@ static const struct snd_pcm_ops snd_wss_capture_ops = {
 	.prepare =	snd_wss_capture_prepare,
 	.trigger =	snd_wss_trigger,
 	.pointer =	snd_wss_capture_pointer,
+	.get_time_info = snd_wss_get_time_info,
 };
 
 int snd_wss_pcm(struct snd_wss *chip, int device)
@@ -1611,7 +2729,7 @@ int snd_wss_pcm(struct snd_wss *chip, int device)
 	/* global setup */
 	pcm->private_data = chip;
 	pcm->info_flags = 0;
-	if (chip->hardware != WSS_HW_INTERWAVE)
+	if (snd_wss_hardware(chip) != WSS_HW_INTERWAVE)
 		pcm->info_flags |= SNDRV_PCM_INFO_JOINT_DUPLEX;
 	strscpy(pcm->name, snd_wss_chip_id(chip));
 
@@ -1623,6 +2741,7 @@ int snd_wss_pcm(struct snd_wss *chip, int device)
 }
 EXPORT_SYMBOL(snd_wss_pcm);
 
+#ifdef CONFIG_SND_WSS_TIMER
 static void snd_wss_timer_free(struct snd_timer *timer)
 {
 	struct snd_wss *chip = timer->private_data;
@@ -1652,6 +2771,7 @@ int snd_wss_timer(struct snd_wss *chip, int device)
 	return 0;
 }
 EXPORT_SYMBOL(snd_wss_timer);
+#endif /* CONFIG_SND_WSS_TIMER */
 
 /*
  *  MIXER part
@@ -1676,7 +2796,7 @@ static int snd_wss_info_mux(struct snd_kcontrol *kcontrol,
 		return -EINVAL;
 	if (!strcmp(chip->card->driver, "GUS MAX"))
 		ptexts = gusmax_texts;
-	switch (chip->hardware) {
+	switch (snd_wss_hardware(chip)) {
 	case WSS_HW_INTERWAVE:
 		ptexts = gusmax_texts;
 		break;
@@ -1769,7 +2889,7 @@ int snd_wss_put_single(struct snd_kcontrol *kcontrol,
 	guard(spinlock_irqsave)(&chip->reg_lock);
 	val = (chip->image[reg] & ~(mask << shift)) | val;
 	change = val != chip->image[reg];
-	snd_wss_out(chip, reg, val);
+	snd_wss_out_mixer(chip, reg, val);
 	return change;
 }
 EXPORT_SYMBOL(snd_wss_put_single);
@@ -1836,13 +2956,13 @@ int snd_wss_put_double(struct snd_kcontrol *kcontrol,
 		val2 = (chip->image[right_reg] & ~(mask << shift_right)) | val2;
 		change = val1 != chip->image[left_reg] ||
 			 val2 != chip->image[right_reg];
-		snd_wss_out(chip, left_reg, val1);
-		snd_wss_out(chip, right_reg, val2);
+		snd_wss_out_mixer(chip, left_reg, val1);
+		snd_wss_out_mixer(chip, right_reg, val2);
 	} else {
 		mask = (mask << shift_left) | (mask << shift_right);
 		val1 = (chip->image[left_reg] & ~mask) | val1 | val2;
 		change = val1 != chip->image[left_reg];
-		snd_wss_out(chip, left_reg, val1);
+		snd_wss_out_mixer(chip, left_reg, val1);
 	}
 	return change;
 }
@@ -1915,10 +3035,10 @@ int snd_wss_mixer(struct snd_wss *chip)
 	strscpy(card->mixername, chip->pcm->name);
 
 	/* Use only the first 11 entries on AD1848 */
-	if (chip->hardware & WSS_HW_AD1848_MASK)
+	if (snd_wss_hardware(chip) & WSS_HW_AD1848_MASK)
 		count = 11;
 	/* There is no loopback on OPTI93X */
-	else if (chip->hardware == WSS_HW_OPTI93X)
+	else if (snd_wss_hardware(chip) == WSS_HW_OPTI93X)
 		count = 9;
 
 	for (idx = 0; idx < count; idx++) {
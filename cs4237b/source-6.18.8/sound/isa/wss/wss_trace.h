@@ -0,0 +1,172 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ *  linic@hotmail.ca: trace events of the WSS library. With CONFIG_TRACING off
+ *  these compile to nothing. On the 560z:
+ *    echo 1 > /sys/kernel/tracing/events/snd_wss/enable
+ *    cat /sys/kernel/tracing/trace_pipe
+ *  ns is the time since the register access started, INIT wait included.
+ *  deferred means INIT didn't clear in time and snd_wss_pending_work writes
+ *  the value later; on a read, that the value came from the image because
+ *  such a write is still waiting.
+ */
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM snd_wss
+
+#if !defined(_WSS_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _WSS_TRACE_H
+
+#include <linux/tracepoint.h>
+#include <linux/sched/clock.h>
+#include <sound/wss.h>
+
+DECLARE_EVENT_CLASS(snd_wss_reg,
+	TP_PROTO(struct snd_wss *chip, unsigned char reg, unsigned char val,
+		 u64 start, bool deferred),
+	TP_ARGS(chip, reg, val, start, deferred),
+	TP_STRUCT__entry(
+		__field(int, card)
+		__field(unsigned char, reg)
+		__field(unsigned char, val)
+		__field(bool, deferred)
+		__field(u64, ns)
+	),
+	TP_fast_assign(
+		__entry->card = chip->card->number;
+		__entry->reg = reg;
+		__entry->val = val;
+		__entry->deferred = deferred;
+		__entry->ns = local_clock() - start;
+	),
+	TP_printk("card=%d reg=0x%02x val=0x%02x ns=%llu%s",
+		  __entry->card, __entry->reg, __entry->val, __entry->ns,
+		  __entry->deferred ? " deferred" : "")
+);
+
+DEFINE_EVENT(snd_wss_reg, snd_wss_out,
+	TP_PROTO(struct snd_wss *chip, unsigned char reg, unsigned char val,
+		 u64 start, bool deferred),
+	TP_ARGS(chip, reg, val, start, deferred)
+);
+
+DEFINE_EVENT(snd_wss_reg, snd_wss_in,
+	TP_PROTO(struct snd_wss *chip, unsigned char reg, unsigned char val,
+		 u64 start, bool deferred),
+	TP_ARGS(chip, reg, val, start, deferred)
+);
+
+DEFINE_EVENT(snd_wss_reg, snd_cs4236_ext_out,
+	TP_PROTO(struct snd_wss *chip, unsigned char reg, unsigned char val,
+		 u64 start, bool deferred),
+	TP_ARGS(chip, reg, val, start, deferred)
+);
+
+DEFINE_EVENT(snd_wss_reg, snd_cs4236_ext_in,
+	TP_PROTO(struct snd_wss *chip, unsigned char reg, unsigned char val,
+		 u64 start, bool deferred),
+	TP_ARGS(chip, reg, val, start, deferred)
+);
+
+/* i0 is R0 when MCE goes up; INIT set there means MCE wasn't written. */
+TRACE_EVENT(snd_wss_mce_up,
+	TP_PROTO(struct snd_wss *chip, unsigned char i0),
+	TP_ARGS(chip, i0),
+	TP_STRUCT__entry(
+		__field(int, card)
+		__field(unsigned char, i0)
+	),
+	TP_fast_assign(
+		__entry->card = chip->card->number;
+		__entry->i0 = i0;
+	),
+	TP_printk("card=%d i0=0x%02x%s", __entry->card, __entry->i0,
+		  __entry->i0 & CS4231_INIT ? " init" : "")
+);
+
+/* The wait for the calibration after MCE went down. */
+TRACE_EVENT(snd_wss_mce_down,
+	TP_PROTO(struct snd_wss *chip, u64 start, unsigned char i0,
+		 unsigned char i11, bool aci_timeout, bool init_timeout),
+	TP_ARGS(chip, start, i0, i11, aci_timeout, init_timeout),
+	TP_STRUCT__entry(
+		__field(int, card)
+		__field(u64, calib_ns)
+		__field(unsigned char, i0)
+		__field(unsigned char, i11)
+		__field(bool, aci_timeout)
+		__field(bool, init_timeout)
+	),
+	TP_fast_assign(
+		__entry->card = chip->card->number;
+		__entry->calib_ns = local_clock() - start;
+		__entry->i0 = i0;
+		__entry->i11 = i11;
+		__entry->aci_timeout = aci_timeout;
+		__entry->init_timeout = init_timeout;
+	),
+	TP_printk("card=%d calib_ns=%llu i0=0x%02x i11=0x%02x%s%s",
+		  __entry->card, __entry->calib_ns, __entry->i0, __entry->i11,
+		  __entry->aci_timeout ? " aci_timeout" : "",
+		  __entry->init_timeout ? " init_timeout" : "")
+);
+
+/* The sleeping wait for INIT before MCE goes down. */
+TRACE_EVENT(snd_wss_busy_wait,
+	TP_PROTO(struct snd_wss *chip, u64 waited_ns, bool timed_out),
+	TP_ARGS(chip, waited_ns, timed_out),
+	TP_STRUCT__entry(
+		__field(int, card)
+		__field(u64, waited_ns)
+		__field(bool, timed_out)
+	),
+	TP_fast_assign(
+		__entry->card = chip->card->number;
+		__entry->waited_ns = waited_ns;
+		__entry->timed_out = timed_out;
+	),
+	TP_printk("card=%d waited_ns=%llu%s", __entry->card,
+		  __entry->waited_ns, __entry->timed_out ? " timeout" : "")
+);
+
+/* I24 read by the interrupt handler. */
+TRACE_EVENT(snd_wss_irq,
+	TP_PROTO(struct snd_wss *chip, unsigned char status),
+	TP_ARGS(chip, status),
+	TP_STRUCT__entry(
+		__field(int, card)
+		__field(unsigned char, status)
+	),
+	TP_fast_assign(
+		__entry->card = chip->card->number;
+		__entry->status = status;
+	),
+	TP_printk("card=%d i24=0x%02x", __entry->card, __entry->status)
+);
+
+/* what is the PEN/CEN bits the command applies to, i9 what I9 was set to. */
+TRACE_EVENT(snd_wss_trigger,
+	TP_PROTO(struct snd_wss *chip, int cmd, unsigned int what),
+	TP_ARGS(chip, cmd, what),
+	TP_STRUCT__entry(
+		__field(int, card)
+		__field(int, cmd)
+		__field(unsigned char, what)
+		__field(unsigned char, i9)
+	),
+	TP_fast_assign(
+		__entry->card = chip->card->number;
+		__entry->cmd = cmd;
+		__entry->what = what;
+		__entry->i9 = chip->image[CS4231_IFACE_CTRL];
+	),
+	TP_printk("card=%d cmd=%d what=0x%02x i9=0x%02x", __entry->card,
+		  __entry->cmd, __entry->what, __entry->i9)
+);
+
+#endif /* _WSS_TRACE_H */
+
+/* This part must be outside the protection above. */
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH ../../sound/isa/wss
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE wss_trace
+#include <trace/define_trace.h>
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2026  linic@hotmail.ca Subject to GPL-3.0 license.
+ * https://github.com/linic/tcl-core-560z
+ *
+ * Plays silence on the CS4237B and asks for a link audio timestamp on every
+ * status query. Prints how much the system time minus the audio time moves
+ * around, which is the jitter of the timestamps snd_wss_get_time_info reports.
+ *
+ * On the 560z:
+ *   tce-load -i compiletc alsa-dev
+ *   gcc -O2 -Wall -o tstamp-jitter tstamp-jitter.c -lasound -lm
+ *   ./tstamp-jitter [device] [rate] [period frames] [seconds]
+ * Defaults are hw:0,0 48000 256 10.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <alsa/asoundlib.h>
+
+#define CHANNELS	2
+
+static long long ts_to_ns(const snd_htimestamp_t *ts)
+{
+	return ts->tv_sec * 1000000000LL + ts->tv_nsec;
+}
+
+static int check(int err, const char *what)
+{
+	if (err < 0) {
+		fprintf(stderr, "%s: %s\n", what, snd_strerror(err));
+		exit(1);
+	}
+	return err;
+}
+
+static void setup(snd_pcm_t *pcm, unsigned int rate, snd_pcm_uframes_t period)
+{
+	snd_pcm_hw_params_t *hw;
+	snd_pcm_sw_params_t *sw;
+	snd_pcm_uframes_t buffer = period * 4;
+
+	snd_pcm_hw_params_alloca(&hw);
+	check(snd_pcm_hw_params_any(pcm, hw), "hw_params_any");
+	if (!snd_pcm_hw_params_supports_audio_ts_type(hw, SND_PCM_AUDIO_TSTAMP_TYPE_LINK)) {
+		fprintf(stderr, "the device doesn't report link timestamps\n");
+		exit(1);
+	}
+	check(snd_pcm_hw_params_set_access(pcm, hw, SND_PCM_ACCESS_RW_INTERLEAVED), "access");
+	check(snd_pcm_hw_params_set_format(pcm, hw, SND_PCM_FORMAT_S16_LE), "format");
+	check(snd_pcm_hw_params_set_channels(pcm, hw, CHANNELS), "channels");
+	check(snd_pcm_hw_params_set_rate(pcm, hw, rate, 0), "rate");
+	check(snd_pcm_hw_params_set_period_size_near(pcm, hw, &period, NULL), "period");
+	check(snd_pcm_hw_params_set_buffer_size_near(pcm, hw, &buffer), "buffer");
+	check(snd_pcm_hw_params(pcm, hw), "hw_params");
+
+	snd_pcm_sw_params_alloca(&sw);
+	check(snd_pcm_sw_params_current(pcm, sw), "sw_params_current");
+	check(snd_pcm_sw_params_set_tstamp_mode(pcm, sw, SND_PCM_TSTAMP_ENABLE), "tstamp_mode");
+	check(snd_pcm_sw_params_set_tstamp_type(pcm, sw, SND_PCM_TSTAMP_TYPE_MONOTONIC), "tstamp_type");
+	check(snd_pcm_sw_params(pcm, sw), "sw_params");
+}
+
+int main(int argc, char **argv)
+{
+	const char *device = argc > 1 ? argv[1] : "hw:0,0";
+	unsigned int rate = argc > 2 ? atoi(argv[2]) : 48000;
+	snd_pcm_uframes_t period = argc > 3 ? atoi(argv[3]) : 256;
+	unsigned int seconds = argc > 4 ? atoi(argv[4]) : 10;
+	snd_pcm_audio_tstamp_config_t config = {
+		.type_requested = SND_PCM_AUDIO_TSTAMP_TYPE_LINK,
+	};
+	snd_pcm_audio_tstamp_report_t report;
+	snd_pcm_status_t *status;
+	snd_htimestamp_t sys_ts, audio_ts;
+	long long offset, first = 0, min = 0, max = 0;
+	double sum = 0, sum2 = 0, mean;
+	unsigned long samples = 0, loops;
+	unsigned int accuracy = 0;
+	short *silence;
+	snd_pcm_t *pcm;
+
+	check(snd_pcm_open(&pcm, device, SND_PCM_STREAM_PLAYBACK, 0), device);
+	setup(pcm, rate, period);
+	silence = calloc(period, CHANNELS * sizeof(*silence));
+	snd_pcm_status_alloca(&status);
+
+	for (loops = (unsigned long)seconds * rate / period; loops; loops--) {
+		if (snd_pcm_writei(pcm, silence, period) < 0) {
+			check(snd_pcm_prepare(pcm), "prepare");
+			continue;
+		}
+		if (snd_pcm_state(pcm) != SND_PCM_STATE_RUNNING)
+			continue;
+		snd_pcm_status_set_audio_htstamp_config(status, &config);
+		check(snd_pcm_status(pcm, status), "status");
+		snd_pcm_status_get_audio_htstamp_report(status, &report);
+		if (report.actual_type != SND_PCM_AUDIO_TSTAMP_TYPE_LINK)
+			continue;
+		if (report.accuracy_report)
+			accuracy = report.accuracy;
+		snd_pcm_status_get_htstamp(status, &sys_ts);
+		snd_pcm_status_get_audio_htstamp(status, &audio_ts);
+		/* Constant while the codec clock and the system clock agree. */
+		offset = ts_to_ns(&sys_ts) - ts_to_ns(&audio_ts);
+		if (!samples)
+			first = offset;
+		offset -= first;
+		if (!samples || offset < min)
+			min = offset;
+		if (!samples || offset > max)
+			max = offset;
+		sum += offset;
+		sum2 += (double)offset * offset;
+		samples++;
+	}
+	snd_pcm_drop(pcm);
+	snd_pcm_close(pcm);
+	free(silence);
+
+	if (!samples) {
+		fprintf(stderr, "no link timestamp was reported\n");
+		return 1;
+	}
+	mean = sum / samples;
+	printf("samples            %lu\n", samples);
+	printf("reported accuracy  %u ns\n", accuracy);
+	printf("offset min         %lld ns\n", min);
+	printf("offset max         %lld ns\n", max);
+	printf("jitter peak-peak   %lld ns\n", max - min);
+	printf("jitter stddev      %.0f ns\n", sqrt(sum2 / samples - mean * mean));
+	return 0;
+}
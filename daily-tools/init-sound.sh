@@ -24,6 +24,10 @@
 # set to the go to the wrong values...? Also unmute the sound
 # using the Fn and volume keys of your keyboard. Make sure you
 # hear the "beep" the volume up keybaoard key produces.
+# With the kernel built from cs4237b, adding
+# `snd_cs4236.master_volume=100 snd_cs4236.pcm_volume=100` to the
+# boot command line sets those volumes at probe and only mpg123 is
+# needed below.
 ##################################################################
 
 # Required for alsamixer to work.
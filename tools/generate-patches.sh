@@ -17,8 +17,8 @@ normalize_patch_header()
 {
   FILE=$1
   ORIG_PATH=$2
-  sed -i "1,2s|.*/${ORIG_PATH}\.orig|a/${ORIG_PATH}|g" "$FILE"
-  sed -i "1,2s|.*/${ORIG_PATH}|b/${ORIG_PATH}|g"       "$FILE"
+  sed -i "1s|^--- .*/${ORIG_PATH}\.orig|--- a/${ORIG_PATH}|" "$FILE"
+  sed -i "2s|^+++ .*/${ORIG_PATH}|+++ b/${ORIG_PATH}|"       "$FILE"
   sed -i '1,2s/\([^ ]*\)\t.*/\1/' "$FILE"
 }
 
@@ -49,6 +49,17 @@ generate_patches()
   normalize_patch_header "$PATCH/cs4236_lib.c.patch" "sound/isa/cs423x/cs4236_lib.c"
   normalize_patch_header "$PATCH/cs4236.c.patch"     "sound/isa/cs423x/cs4236.c"
   normalize_patch_header "$PATCH/wss.h.patch"        "include/sound/wss.h"
+
+  # wss_trace.h doesn't exist upstream, so it's a patch creating the file.
+  if [ -f "$SOURCE/sound/isa/wss/wss_trace.h" ]; then
+    diff -u /dev/null "$SOURCE/sound/isa/wss/wss_trace.h" > "$PATCH/wss_trace.h.patch"
+    normalize_patch_header "$PATCH/wss_trace.h.patch" "sound/isa/wss/wss_trace.h"
+  fi
+
+  # New Kconfig options aren't a diff; tools/patch-cs4236.sh appends the file.
+  if [ -f "$SOURCE/sound/isa/Kconfig.cs4237b" ]; then
+    cp "$SOURCE/sound/isa/Kconfig.cs4237b" "$PATCH/Kconfig.cs4237b"
+  fi
 }
 
 main()
@@ -5,3 +5,15 @@ patch -p1 < patches/cs4236_lib.c.patch
 patch -p1 < patches/wss.h.patch
 patch -p1 < patches/wss_lib.c.patch
 
+# Only the patch sets with trace events have this one.
+if [ -f patches/wss_trace.h.patch ]; then
+  patch -p1 < patches/wss_trace.h.patch
+fi
+
+# Only the patch sets with Kconfig options ship a Kconfig.cs4237b.
+# SND_CS4236 gets its OPL3 and MPU-401 selects back from there, under the
+# options which let the 560z leave them out.
+if [ -f patches/Kconfig.cs4237b ]; then
+  sed -i '/^config SND_CS4236$/,/^config /{/^\tselect SND_OPL3_LIB$/d;/^\tselect SND_MPU401_UART$/d}' sound/isa/Kconfig
+  cat patches/Kconfig.cs4237b >> sound/isa/Kconfig
+fi
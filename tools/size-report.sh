@@ -0,0 +1,52 @@
+#!/bin/sh
+
+###################################################################
+# Copyright (C) 2026 linic@hotmail.ca Subject to GPL-3.0 license. #
+# https://github.com/linic/tcl-core-560z                          #
+###################################################################
+
+##################################################################
+# Compares two built kernel trees, for example one built with
+# CONFIG_SND_WSS_CS4237B_ONLY=y and one without. .config-6.18 is
+# monolithic so everything in vmlinux stays in RAM on the 560z.
+# Prints the bzImage sizes, the text/data/bss of vmlinux and of
+# the sound/isa objects, then the per-symbol difference from
+# scripts/bloat-o-meter.
+# Example:
+# ./size-report.sh ~/linux-6.18.8-before ~/linux-6.18.8-after
+##################################################################
+
+usage()
+{
+  echo "Please enter two built kernel source directories"
+  echo "Example: ./size-report.sh ~/linux-6.18.8-before ~/linux-6.18.8-after"
+}
+
+report()
+{
+  for DIR in "$1" "$2"; do
+    echo "== $DIR"
+    ls -l "$DIR/arch/x86/boot/bzImage" | awk '{ print "bzImage " $5 " bytes" }'
+    size "$DIR/vmlinux"
+    size "$DIR"/sound/isa/wss/*.o "$DIR"/sound/isa/cs423x/*.o 2>/dev/null
+  done
+  echo "== bloat-o-meter $1 $2"
+  "$2/scripts/bloat-o-meter" "$1/vmlinux" "$2/vmlinux"
+}
+
+main()
+{
+  if [ ! $# -eq 2 ]; then
+    usage
+    exit 1
+  fi
+  for DIR in "$1" "$2"; do
+    if [ ! -f "$DIR/vmlinux" ] || [ ! -f "$DIR/arch/x86/boot/bzImage" ]; then
+      echo "$DIR has no vmlinux or bzImage. Build it first."
+      exit 2
+    fi
+  done
+  report "$1" "$2"
+}
+
+main "$@"